@@ -0,0 +1,21 @@
+#include "arena.h"
+
+#include <atomic>
+
+namespace Arena {
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+} // namespace
+
+uint64_t Allocations() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void CountAllocation() {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace Arena
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Storage of world generation. Every field plane, noise table and scratch buffer of a
+// pass is a Plane, which is resized to the pass and never gives its capacity back, so
+// the planes grow to the largest map generated so far and later generations reuse them.
+// Planes count the heap allocations they make: generating a map no larger than an
+// earlier one makes none.
+// Resizing a plane leaves elements of trivial types uninitialized, so that growing it costs
+// nothing up front: the stages write every element before reading it, in their sliced units
+namespace Arena {
+
+/* heap allocations made by planes since the start of the program */
+uint64_t Allocations();
+
+/* called by Allocator on every allocation */
+void CountAllocation();
+
+/* std::allocator that counts its allocations */
+template<typename T>
+struct Allocator {
+    using value_type = T;
+
+    Allocator() = default;
+    template<typename U>
+    Allocator(const Allocator<U>&) {}
+
+    T* allocate(size_t n) {
+        CountAllocation();
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    /* default-initializes, where std::allocator value-initializes */
+    template<typename U>
+    void construct(U* p) {
+        ::new (static_cast<void*>(p)) U;
+    }
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    bool operator==(const Allocator<U>&) const {
+        return true;
+    }
+    template<typename U>
+    bool operator!=(const Allocator<U>&) const {
+        return false;
+    }
+};
+
+template<typename T>
+using Plane = std::vector<T, Allocator<T>>;
+
+} // namespace Arena
@@ -1,9 +1,84 @@
 #include <driver/driver.h>
+#include <core/headless_graphics.h>
+#include <library/alloc_tracker.h>
 #include "main_frame.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
 using namespace REngine;
 
-int main() {
+// App                      - interactive window
+// App --headless N [out] [--check-allocations]
+//                          - render N frames offscreen as fast as possible,
+//                            print timings and optionally save the last frame to out.
+//                            Built with RENGINE_TRACK_ALLOCATIONS it fails with exit
+//                            code 2 if any frame after the world settled allocated, i.e.
+//                            was complete and went through a day.
+//                            --check-allocations runs N such frames after it settled,
+//                            however long generating it takes, and fails with
+//                            exit code 1 in builds without tracking, where nothing would
+//                            be checked
+int RunHeadless(uint32_t frames, const char* dumpPath, bool checkAllocations) {
+    if (checkAllocations && !AllocTracker::Enabled()) {
+        std::cerr << "--check-allocations needs a build with -DRENGINE_TRACK_ALLOCATIONS=ON" << std::endl;
+        return 1;
+    }
+    auto graphics = std::make_shared<HeadlessGraphics>(_screenSize);
+    // frames from the settled world on are the steady state
+    Driver::Promote(std::make_unique<HeadlessDriver>(
+            std::make_unique<MainFrame>(graphics),
+            HeadlessDriver::Settings{
+                .frames = frames,
+                .frameDeltaMs = 1000.f / 60,
+                .framesAfterSettling = checkAllocations,
+            } ));
+    Driver::King()->Initialize();
+    Driver::King()->Run();
+
+    const auto& report = Driver::King()->Cast<HeadlessDriver>()->GetReport();
+    std::cout << "frames " << report.frames
+              << " total_ms " << report.totalMs
+              << " update_ms " << report.averageUpdateMs
+              << " render_ms " << report.averageRenderMs
+              << " p50_ms " << report.p50Ms
+              << " p95_ms " << report.p95Ms
+              << " p99_ms " << report.p99Ms
+              << " max_ms " << report.maxMs << std::endl;
+
+    if (AllocTracker::Enabled()) {
+        std::cout << "allocations " << report.allocations
+                  << " steady_frames " << report.steadyFrames
+                  << " steady_allocations " << report.steadyAllocations
+                  << " allocating_steady_frames " << report.allocatingSteadyFrames << std::endl;
+    }
+
+    if (dumpPath && !graphics->SaveToFile(dumpPath)) {
+        return 1;
+    }
+    if (report.steadyAllocations > 0) {
+        std::cerr << "steady frames allocated, sampled call stacks:" << std::endl;
+        AllocTracker::PrintSamples(std::cerr);
+        return 2;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "--headless") == 0) {
+        const char* dumpPath = nullptr;
+        bool checkAllocations = false;
+        for (int i = 3; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--check-allocations") == 0) {
+                checkAllocations = true;
+            } else {
+                dumpPath = argv[i];
+            }
+        }
+        return RunHeadless(std::atoi(argv[2]), dumpPath, checkAllocations);
+    }
+
     Driver::Promote(std::make_unique<SingleFrameDriver>(
             std::make_unique<MainFrame>(),
             SingleFrameDriver::Settings{ .minimumUpdateDelayMs = 0 } ));
@@ -1,10 +1,13 @@
 #include <core/frame.h>
 #include <core/color.h>
+#include <core/perf_overlay.h>
 #include <library/vec2.h>
+#include <library/profiler.h>
 
 #include "world.h"
 #include "parse_config.h"
 
+#include <cstdio>
 #include <fstream>
 
 using namespace REngine;
@@ -24,9 +27,19 @@ public:
             MakeGenericWindow(_screenSize, "Demo app"))
     {}
 
+    /* renders through the given backend instead of a window, e.g. HeadlessGraphics */
+    explicit MainFrame(Graphics::SPtr graphics)
+        : Frame(
+            Frame::Settings{
+                .id = "MainFrame",
+                .screenSize = _screenSize,
+            },
+            std::move(graphics))
+    {}
+
     void Initialize() override {
         std::cout << "Init" << std::endl;
-        _world.Generate(ParseConfigFromFile("world_settings.json"));
+        GenerateWorld();
 
         Ic()->keyPressedCallback = [&](const sf::Keyboard::Key& key) {
             switch (key) {
@@ -40,7 +53,15 @@ public:
                 _world.SetRenderedLayer(World::Layer::HUMIDITY);
                 break;
             case sf::Keyboard::Space:
-                _world.Generate(ParseConfigFromFile("world_settings.json"));
+                GenerateWorld();
+                break;
+            case sf::Keyboard::O:
+                _overlay.Toggle();
+                break;
+            case sf::Keyboard::P:
+                if (Profiler::ExportChromeTrace("trace.json")) {
+                    std::cout << "Profile written to trace.json" << std::endl;
+                }
                 break;
             default:
                 break;
@@ -65,18 +86,60 @@ public:
     }
 
     bool Update(float elapsedMs) override {
+        // finer passes are built a slice per frame, every finished one is shown
+        if (_world.Refine(_generationBudgetMs)) {
+            ShowGenerationTimings();
+        }
+        if (_world.Complete()) {
+            _completeMs += elapsedMs;
+        }
         _world.Tick(elapsedMs);
         return Frame::Update(elapsedMs);
     }
 
+    /* the world is complete and went through a whole day, so the shadows were built for
+     * every sun position and further frames reuse their buffers */
+    bool IsSettled() const override {
+        return _world.Complete() && _completeMs >= _dayDurationMs;
+    }
+
     void Render() override {
         Gr()->SetFillColor(REngine::Color::WHITE);
         Gr()->Fill();
 
         _world.Render(Gr(), _screenSize);
+        _overlay.Render(Gr(), Stats(), _screenSize);
         Frame::Render();
     }
 
 private:
+    void GenerateWorld() {
+        Config config = ParseConfigFromFile("world_settings.json");
+        _generationBudgetMs = config.generationBudgetMs;
+        _dayDurationMs = config.dayDuration;
+        _completeMs = 0;
+        _world.GenerateProgressive(config);
+        ShowGenerationTimings();
+    }
+
+    void ShowGenerationTimings() {
+        std::string details = "generation:";
+        double total = 0;
+        for (const auto& stage : _world.GenerationTimings()) {
+            char line[64];
+            std::snprintf(line, sizeof(line), "\n  %-10s %8.1f ms", stage.name, stage.ms);
+            details += line;
+            total += stage.ms;
+        }
+        char line[64];
+        std::snprintf(line, sizeof(line), "\n  %-10s %8.1f ms", "total", total);
+        _overlay.SetDetails(details + line);
+    }
+
     World _world;
+    double _generationBudgetMs = 0;
+    double _dayDurationMs = 0;
+    /* game time since the world was complete */
+    double _completeMs = 0;
+    PerfOverlay _overlay;
 };
@@ -0,0 +1,14 @@
+#include "noise.h"
+
+#include "perlin.h"
+#include "simplex.h"
+
+std::unique_ptr<Noise> Noise::Create(Engine engine) {
+    switch (engine) {
+    case Engine::SIMPLEX:
+        return std::make_unique<SimplexNoise>();
+    case Engine::PERLIN:
+        break;
+    }
+    return std::make_unique<PerlinNoise>();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <library/vec2.h>
+#include <library/ext_math.h>
+
+// Scalar of the noise batches and of the world's field planes, RENGINE_FLOAT_WORLD
+// halves their size and doubles the lanes of the SSE loops over them
+#if defined(RENGINE_FLOAT_WORLD)
+using Real = float;
+#else
+using Real = double;
+#endif
+
+/* std::function whose copies share one callable, so copying noise settings into every
+ * noise that Generates from them does not allocate. The callable is immutable */
+template<typename Signature>
+class SharedFunction;
+
+template<typename R, typename... Args>
+class SharedFunction<R(Args...)> {
+public:
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SharedFunction>>>
+    SharedFunction(F&& f)
+        : _function(std::make_shared<const std::function<R(Args...)>>(std::forward<F>(f)))
+    {}
+
+    R operator()(Args... args) const {
+        return (*_function)(std::forward<Args>(args)...);
+    }
+
+private:
+    std::shared_ptr<const std::function<R(Args...)>> _function;
+};
+
+/* Fractal gradient noise over [0, 1]^2. Octave i has baseGridResolution * 2^i lattice
+ * cells per unit and is weighted by amplitudeGenerator(i), the weighted mean goes
+ * through transformerFunction */
+class Noise {
+public:
+    enum class Engine {
+        PERLIN = 0,
+        SIMPLEX,
+    };
+
+    struct Settings {
+        Engine engine = Engine::PERLIN;
+        uint32_t depth = 5;
+        uint32_t baseGridResolution = 8;
+        /* periodic lattices, the noise repeats every 1 along x or y. Perlin only */
+        bool wrapX = false;
+        bool wrapY = false;
+        SharedFunction<double(uint32_t)> amplitudeGenerator = [depth = depth](uint32_t x) {
+            return ExtMath::PowInt(2., depth - 1 - x) * 2;
+        };
+        SharedFunction<double(double)> transformerFunction = [](double x) { return x; };
+    };
+
+    /* the engine selected by engine */
+    static std::unique_ptr<Noise> Create(Engine engine);
+
+    virtual ~Noise() = default;
+
+    virtual Engine GetEngine() const = 0;
+    /* draws new lattices, tables of an earlier Generate of the same size are reused */
+    virtual void Generate(const Settings& settings) = 0;
+    virtual double operator()(Vec2<double> p) = 0;
+
+    /* out[i] = (*this)({x[i], y[i]}), walks octave by octave over the whole batch */
+    virtual void Sample(const Real* x, const Real* y, Real* out, size_t count) = 0;
+};
@@ -2,6 +2,7 @@
 #include <library/ext_math.h>
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <stdexcept>
 
 using Json = nlohmann::json;
 using Biome = World::Settings::Biome;
@@ -54,6 +55,11 @@ void Parse(Biome& var, const Json& json) {
     GET_IF_PRESENT(var.surfaceAlbedo, "surface_albedo")
     PARSE_IF_PRESENT(var.surfaceColor, "surface_color")
     PARSE_IF_PRESENT(var.slopeBounds, "slope_bounds")
+    PARSE_IF_PRESENT(var.lakeDepthBounds, "lake_depth_bounds")
+    GET_IF_PRESENT(var.river, "river")
+    // slope is acos(normal.z) and cos decreases on [0, 180], so the bounds swap
+    var.normalZBounds.min = std::cos(ToRadian(std::min(var.slopeBounds.max, 180.)));
+    var.normalZBounds.max = std::cos(ToRadian(std::max(var.slopeBounds.min, 0.)));
 
     std::string type = "normal";
     GET_IF_PRESENT(type, "surface_type")
@@ -64,6 +70,40 @@ void Parse(Biome& var, const Json& json) {
     }
 }
 
+template<>
+void Parse(World::Settings::Erosion& var, const Json& json) {
+    GET_IF_PRESENT(var.iterations, "iterations")
+    GET_IF_PRESENT(var.rain, "rain")
+    assert(var.rain >= 0);
+    GET_IF_PRESENT(var.evaporation, "evaporation")
+    GET_IF_PRESENT(var.capacity, "capacity")
+    GET_IF_PRESENT(var.erosionRate, "erosion_rate")
+    GET_IF_PRESENT(var.depositionRate, "deposition_rate")
+}
+
+template<>
+void Parse(World::Settings::Warp& var, const Json& json) {
+    GET_IF_PRESENT(var.strength, "strength")
+    GET_IF_PRESENT(var.depth, "depth")
+    GET_IF_PRESENT(var.baseGridResolution, "base_grid_resolution")
+}
+
+template<>
+void Parse(World::Settings::Climate& var, const Json& json) {
+    GET_IF_PRESENT(var.enabled, "enabled")
+    GET_IF_PRESENT(var.stepMs, "step_ms")
+    GET_IF_PRESENT(var.maxStepsPerTick, "max_steps_per_tick")
+    GET_IF_PRESENT(var.diffusion, "diffusion")
+    GET_IF_PRESENT(var.insolation, "insolation")
+    GET_IF_PRESENT(var.cooling, "cooling")
+    GET_IF_PRESENT(var.lapseRate, "lapse_rate")
+    GET_IF_PRESENT(var.waterHeating, "water_heating")
+    GET_IF_PRESENT(var.waterCooling, "water_cooling")
+    PARSE_IF_PRESENT(var.wind, "wind")
+    GET_IF_PRESENT(var.evaporation, "evaporation")
+    GET_IF_PRESENT(var.humidityRelaxation, "humidity_relaxation")
+}
+
 template<>
 void Parse(ExtMath::Polynomial<double>& poly, const Json& json) {
     std::vector<uint32_t> powers;
@@ -105,23 +145,47 @@ void ParseNoiseTransformer(Callback& callback, const Json& json) {
 }
 
 template<>
-void Parse(PerlinNoise::Settings& settings, const Json& json) {
+void Parse(Noise::Settings& settings, const Json& json) {
+    std::string engine = "perlin";
+    GET_IF_PRESENT(engine, "engine")
+    // a misspelt engine would silently fall back to Perlin, so it fails like malformed JSON
+    if (engine == "perlin") {
+        settings.engine = Noise::Engine::PERLIN;
+    } else if (engine == "simplex") {
+        settings.engine = Noise::Engine::SIMPLEX;
+    } else {
+        throw std::invalid_argument("unknown noise engine \"" + engine + "\", expected \"perlin\" or \"simplex\"");
+    }
     if (json.contains("transformer_function")) {
         ParseNoiseTransformer(settings.transformerFunction, json["transformer_function"]);
     }
     GET_IF_PRESENT(settings.depth, "depth");
-    settings.amplitudeGenerator = [=](uint32_t x) {
-        return std::pow(2, settings.depth - 1 - x) * 2;
+    settings.amplitudeGenerator = [depth = settings.depth](uint32_t x) {
+        return PowInt(2., depth - 1 - x) * 2;
     };
     GET_IF_PRESENT(settings.baseGridResolution, "base_grid_resolution");
+    GET_IF_PRESENT(settings.wrapX, "wrap_x");
+    GET_IF_PRESENT(settings.wrapY, "wrap_y");
 }
 
 Config ParseConfig(const Json& json) {
     World::Settings settings;
 
+    GET_IF_PRESENT(settings.seed, "seed")
     PARSE_IF_PRESENT(settings.worldSize, "world_size")
+    GET_IF_PRESENT(settings.previewScale, "preview_scale")
+    GET_IF_PRESENT(settings.generationBudgetMs, "generation_budget_ms")
     GET_IF_PRESENT(settings.dayDuration, "day_duration")
+    GET_IF_PRESENT(settings.fastMath, "fast_math")
+    GET_IF_PRESENT(settings.shadowUpdateStep, "shadow_update_step")
+    GET_IF_PRESENT(settings.occlusionRadius, "occlusion_radius")
+    PARSE_IF_PRESENT(settings.erosion, "erosion")
+    GET_IF_PRESENT(settings.riverFlow, "river_flow")
+    PARSE_IF_PRESENT(settings.climate, "climate")
     PARSE_IF_PRESENT(settings.heightNoiseSettings, "height_noise")
+    if (json.contains("height_noise")) {
+        Parse(settings.heightWarp, json["height_noise"].value("warp", Json::object()));
+    }
     PARSE_IF_PRESENT(settings.temperatureNoiseSettings, "temperature_noise")
     PARSE_IF_PRESENT(settings.humidityNoiseSettings, "humidity_noise")
 
@@ -1,21 +1,158 @@
 #include "perlin.h"
 
-void PerlinNoise::Generate(Settings settings) {
+#include <algorithm>
+
+namespace {
+
+/* weight of octave I out of Depth when every octave has half the amplitude of the previous,
+ * normalized so the weights sum to 1 */
+template<uint32_t Depth, size_t I>
+constexpr double HalvingWeight() {
+    return static_cast<double>(1u << (Depth - 1 - I)) / ((1u << Depth) - 1);
+}
+
+bool HasHalvingAmplitudes(const Noise::Settings& settings) {
+    if (settings.depth == 0 || settings.amplitudeGenerator(0) == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i + 1 < settings.depth; ++i) {
+        double a = settings.amplitudeGenerator(i);
+        if (std::abs(a - settings.amplitudeGenerator(i + 1) * 2) > std::abs(a) * 1e-12) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+template<typename T>
+Noise::Engine BasicPerlinNoise<T>::GetEngine() const {
+    return Engine::PERLIN;
+}
+
+template<typename T>
+void BasicPerlinNoise<T>::Generate(const Settings& settings) {
     _settings = settings;
 
     _layers.resize(_settings.depth);
     for (uint32_t i = 0; i < _settings.depth; ++i) {
-        _layers[i].Generate(Vec2<uint32_t>(_settings.baseGridResolution * (1 << i), _settings.baseGridResolution * (1 << i)));
+        _layers[i].Generate(Vec2<uint32_t>(_settings.baseGridResolution * (1 << i), _settings.baseGridResolution * (1 << i)),
+                            _settings.wrapX, _settings.wrapY);
+    }
+
+    _evaluate = &BasicPerlinNoise::EvaluateAnyDepth;
+    _sample = &BasicPerlinNoise::SampleAnyDepth;
+    if (!HasHalvingAmplitudes(_settings)) {
+        return;
+    }
+    static_assert(MAX_UNROLLED_DEPTH == 8);
+    switch (_settings.depth) {
+    case 1: Specialize<1>(); break;
+    case 2: Specialize<2>(); break;
+    case 3: Specialize<3>(); break;
+    case 4: Specialize<4>(); break;
+    case 5: Specialize<5>(); break;
+    case 6: Specialize<6>(); break;
+    case 7: Specialize<7>(); break;
+    case 8: Specialize<8>(); break;
+    }
+}
+
+template<typename T>
+double BasicPerlinNoise<T>::operator()(Vec2<double> p) {
+    return (this->*_evaluate)(p);
+}
+
+template<typename T>
+void BasicPerlinNoise<T>::Sample(const Real* x, const Real* y, Real* out, size_t count) {
+    (this->*_sample)(x, y, out, count);
+}
+
+template<typename T>
+template<uint32_t Depth>
+void BasicPerlinNoise<T>::Specialize() {
+    _evaluate = &BasicPerlinNoise::template EvaluateOctaves<Depth>;
+    _sample = &BasicPerlinNoise::template SampleOctaves<Depth>;
+}
+
+template<typename T>
+template<uint32_t Depth, size_t... I>
+T BasicPerlinNoise<T>::Octaves(Vec2<T> p, std::index_sequence<I...>) {
+    const T base = _settings.baseGridResolution;
+    return ((_layers[I](p * (base * (1u << I))) * static_cast<T>(HalvingWeight<Depth, I>())) + ...);
+}
+
+template<typename T>
+template<uint32_t Depth>
+double BasicPerlinNoise<T>::EvaluateOctaves(Vec2<double> p) {
+    return _settings.transformerFunction(Octaves<Depth>(Vec2<T>(p.x, p.y), std::make_index_sequence<Depth>()));
+}
+
+template<typename T>
+template<uint32_t Depth>
+void BasicPerlinNoise<T>::SampleOctaves(const Real* x, const Real* y, Real* out, size_t count) {
+    // still one octave over the whole batch at a time, the lattices of the fine octaves
+    // do not fit in cache together
+    SampleOctaves<Depth>(x, y, out, count, std::make_index_sequence<Depth>());
+    for (size_t j = 0; j < count; ++j) {
+        out[j] = _settings.transformerFunction(out[j]);
+    }
+}
+
+template<typename T>
+template<uint32_t Depth, size_t... I>
+void BasicPerlinNoise<T>::SampleOctaves(const Real* x, const Real* y, Real* out, size_t count, std::index_sequence<I...>) {
+    (SampleOctave<Depth, I>(x, y, out, count), ...);
+}
+
+template<typename T>
+template<uint32_t Depth, size_t I>
+void BasicPerlinNoise<T>::SampleOctave(const Real* x, const Real* y, Real* out, size_t count) {
+    PerlinLayer& layer = _layers[I];
+    const T scale = static_cast<T>(_settings.baseGridResolution) * (1u << I);
+    const T weight = HalvingWeight<Depth, I>();
+    for (size_t j = 0; j < count; ++j) {
+        T v = layer(Vec2<T>(x[j] * scale, y[j] * scale)) * weight;
+        if constexpr (I == 0) {
+            out[j] = v;
+        } else {
+            out[j] += v;
+        }
     }
 }
 
-double PerlinNoise::operator()(Vec2<double> p) {
+template<typename T>
+double BasicPerlinNoise<T>::EvaluateAnyDepth(Vec2<double> p) {
     double v = 0;
     double ampl_sum = 0;
     for (uint32_t i = 0; i < _settings.depth; ++i) {
         double a = _settings.amplitudeGenerator(i);
-        v += _layers[i](p * _settings.baseGridResolution * (1 << i)) * a;
+        double scale = _settings.baseGridResolution * (1 << i);
+        v += _layers[i](Vec2<T>(p.x * scale, p.y * scale)) * a;
         ampl_sum += a;
     }
     return _settings.transformerFunction(v / ampl_sum);
-}
\ No newline at end of file
+}
+
+template<typename T>
+void BasicPerlinNoise<T>::SampleAnyDepth(const Real* x, const Real* y, Real* out, size_t count) {
+    std::fill(out, out + count, 0.);
+    double ampl_sum = 0;
+    for (uint32_t i = 0; i < _settings.depth; ++i) {
+        double a = _settings.amplitudeGenerator(i);
+        const T weight = a;
+        const T scale = _settings.baseGridResolution * (1 << i);
+        PerlinLayer& layer = _layers[i];
+        for (size_t j = 0; j < count; ++j) {
+            out[j] += layer(Vec2<T>(x[j] * scale, y[j] * scale)) * weight;
+        }
+        ampl_sum += a;
+    }
+    for (size_t j = 0; j < count; ++j) {
+        out[j] = _settings.transformerFunction(out[j] / ampl_sum);
+    }
+}
+
+template class BasicPerlinNoise<float>;
+template class BasicPerlinNoise<double>;
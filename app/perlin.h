@@ -1,62 +1,97 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
-#include <vector>
+#include <utility>
 
 #include <library/vec2.h>
 #include <library/ext_math.h>
 
-class PerlinNoise {
-public:
-    struct Settings {
-        uint32_t depth = 5;
-        uint32_t baseGridResolution = 8;
-        std::function<double(uint32_t)> amplitudeGenerator = [=](uint32_t x) {
-            return std::pow(2, depth - 1 - x) * 2;
-        };
-        std::function<double(double)> transformerFunction = [](double x) { return x; };
-    };
+#include "arena.h"
+#include "noise.h"
 
+/* Perlin noise with gradients, interpolation and octave sums in T. PerlinNoise is the one
+ * in the build's Real, both are instantiated to compare them */
+template<typename T>
+class BasicPerlinNoise : public Noise {
 private:
     struct PerlinLayer {
-        std::vector<std::vector<Vec2d>> gradients;
+        /* (gridSize.y + 2) rows of gridSize.x + 2 gradients */
+        Arena::Plane<Vec2<T>> gradients;
         Vec2u gridSize;
 
-        void Generate(Vec2u size) {
+        void Generate(Vec2u size, bool wrapX, bool wrapY) {
             gridSize = size;
-            gradients.assign(size.y + 2, std::vector<Vec2d>(size.x + 2, Vec2d(0, 0)));
+            const size_t stride = size.x + 2;
+            gradients.assign(stride * (size.y + 2), Vec2<T>(0, 0));
             for (uint32_t y = 0; y < size.y + 1; ++y) {
                 for (uint32_t x = 0; x < size.x + 1; ++x) {
                     double a = ExtMath::RandomDouble(0, 2 * ExtMath::PI);
-                    gradients[y][x] = Vec2d(std::cos(a), std::sin(a));
+                    gradients[y * stride + x] = Vec2<T>(std::cos(a), std::sin(a));
                 }
             }
+            // the lattice period is the octave's grid size, the last line repeats the first
+            if (wrapX) {
+                for (uint32_t y = 0; y < size.y + 1; ++y) {
+                    gradients[y * stride + size.x] = gradients[y * stride];
+                }
+            }
+            if (wrapY) {
+                std::copy_n(gradients.begin(), stride, gradients.begin() + size.y * stride);
+            }
         }
 
-        double GetDotGrid(uint32_t ix, uint32_t iy, Vec2d p) {
-            Vec2d dp = Vec2d(p.x - ix, p.y - iy);
-            return dot_prod(dp, gradients[iy][ix]);
+        T GetDotGrid(uint32_t ix, uint32_t iy, Vec2<T> p) {
+            Vec2<T> dp = Vec2<T>(p.x - ix, p.y - iy);
+            return dot_prod(dp, gradients[static_cast<size_t>(iy) * (gridSize.x + 2) + ix]);
         }
 
-        double operator()(Vec2d p) {
+        T operator()(Vec2<T> p) {
             uint32_t ix = std::floor(p.x);
             uint32_t iy = std::floor(p.y);
-            double p00 = GetDotGrid(ix, iy, p);
-            double p10 = GetDotGrid(ix + 1, iy, p);
-            double p01 = GetDotGrid(ix, iy + 1, p);
-            double p11 = GetDotGrid(ix + 1, iy + 1, p);
-            return ExtMath::SmootherstepSquare(p00, p10, p01, p11, Vec2d(p.x - ix, p.y - iy));
+            T p00 = GetDotGrid(ix, iy, p);
+            T p10 = GetDotGrid(ix + 1, iy, p);
+            T p01 = GetDotGrid(ix, iy + 1, p);
+            T p11 = GetDotGrid(ix + 1, iy + 1, p);
+            return ExtMath::SmootherstepSquare(p00, p10, p01, p11, Vec2<T>(p.x - ix, p.y - iy));
         }
     };
 
 public:
-    PerlinNoise() = default;
+    BasicPerlinNoise() = default;
 
-    void Generate(Settings settings);
-    double operator()(Vec2<double> p);
+    Engine GetEngine() const override;
+    void Generate(const Settings& settings) override;
+    double operator()(Vec2<double> p) override;
+    void Sample(const Real* x, const Real* y, Real* out, size_t count) override;
 
 private:
+    // Depths up to MAX_UNROLLED_DEPTH whose amplitudes halve every octave, the default
+    // schedule, are evaluated with the octaves unrolled and constant normalized weights.
+    // Generate picks the evaluators, other settings take the loops over the octaves
+    static constexpr uint32_t MAX_UNROLLED_DEPTH = 8;
+
+    template<uint32_t Depth>
+    void Specialize();
+    template<uint32_t Depth, size_t... I>
+    T Octaves(Vec2<T> p, std::index_sequence<I...>);
+    template<uint32_t Depth>
+    double EvaluateOctaves(Vec2<double> p);
+    template<uint32_t Depth>
+    void SampleOctaves(const Real* x, const Real* y, Real* out, size_t count);
+    template<uint32_t Depth, size_t... I>
+    void SampleOctaves(const Real* x, const Real* y, Real* out, size_t count, std::index_sequence<I...>);
+    template<uint32_t Depth, size_t I>
+    void SampleOctave(const Real* x, const Real* y, Real* out, size_t count);
+
+    double EvaluateAnyDepth(Vec2<double> p);
+    void SampleAnyDepth(const Real* x, const Real* y, Real* out, size_t count);
+
     Settings _settings;
-    std::vector<PerlinLayer> _layers;
+    Arena::Plane<PerlinLayer> _layers;
+    double (BasicPerlinNoise::*_evaluate)(Vec2<double>) = &BasicPerlinNoise::EvaluateAnyDepth;
+    void (BasicPerlinNoise::*_sample)(const Real*, const Real*, Real*, size_t) = &BasicPerlinNoise::SampleAnyDepth;
 };
+
+using PerlinNoise = BasicPerlinNoise<Real>;
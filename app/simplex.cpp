@@ -0,0 +1,105 @@
+#include "simplex.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// skew of the square lattice onto equilateral triangles, and back
+const double F2 = (std::sqrt(3.) - 1) / 2;
+const double G2 = (3 - std::sqrt(3.)) / 6;
+
+// matches the spread of a Perlin layer, so transformer functions work for both engines
+constexpr double SCALE = 40;
+
+// branch-free, which corner falls outside its radius is unpredictable
+double Corner(const Vec2d& gradient, double x, double y) {
+    double t = std::max(0., 0.5 - x * x - y * y);
+    t *= t;
+    return t * t * (gradient.x * x + gradient.y * y);
+}
+
+// samples are never negative in [0, 1]^2, truncation is the floor
+int64_t FloorPositive(double x) {
+    return static_cast<int64_t>(x);
+}
+
+} // namespace
+
+void SimplexNoise::SimplexLayer::Generate() {
+    for (auto& gradient : gradients) {
+        double a = ExtMath::RandomDouble(0, 2 * ExtMath::PI);
+        gradient = Vec2d(std::cos(a), std::sin(a));
+    }
+    std::iota(permutation.begin(), permutation.begin() + 256, 0);
+    for (int i = 255; i > 0; --i) {
+        std::swap(permutation[i], permutation[ExtMath::RandomInt(0, i + 1)]);
+    }
+    std::copy(permutation.begin(), permutation.begin() + 256, permutation.begin() + 256);
+
+}
+
+double SimplexNoise::SimplexLayer::operator()(Vec2d p) const {
+    double s = (p.x + p.y) * F2;
+    int64_t i = FloorPositive(p.x + s);
+    int64_t j = FloorPositive(p.y + s);
+    double t = (i + j) * G2;
+    double x0 = p.x - (i - t);
+    double y0 = p.y - (j - t);
+
+    // the lower or the upper triangle of the skewed cell
+    int i1 = x0 > y0 ? 1 : 0;
+    int j1 = 1 - i1;
+    double x1 = x0 - i1 + G2;
+    double y1 = y0 - j1 + G2;
+    double x2 = x0 - 1 + 2 * G2;
+    double y2 = y0 - 1 + 2 * G2;
+
+    int ii = i & 255;
+    int jj = j & 255;
+    const Vec2d& g0 = gradients[permutation[ii + permutation[jj]]];
+    const Vec2d& g1 = gradients[permutation[ii + i1 + permutation[jj + j1]]];
+    const Vec2d& g2 = gradients[permutation[ii + 1 + permutation[jj + 1]]];
+    return (Corner(g0, x0, y0) + Corner(g1, x1, y1) + Corner(g2, x2, y2)) * SCALE;
+}
+
+Noise::Engine SimplexNoise::GetEngine() const {
+    return Engine::SIMPLEX;
+}
+
+void SimplexNoise::Generate(const Settings& settings) {
+    _settings = settings;
+
+    _layers.resize(_settings.depth);
+    for (auto& layer : _layers) {
+        layer.Generate();
+    }
+}
+
+double SimplexNoise::operator()(Vec2<double> p) {
+    double v = 0;
+    double ampl_sum = 0;
+    for (uint32_t i = 0; i < _settings.depth; ++i) {
+        double a = _settings.amplitudeGenerator(i);
+        v += _layers[i](p * _settings.baseGridResolution * (1 << i)) * a;
+        ampl_sum += a;
+    }
+    return _settings.transformerFunction(v / ampl_sum);
+}
+
+void SimplexNoise::Sample(const Real* x, const Real* y, Real* out, size_t count) {
+    std::fill(out, out + count, 0.);
+    double ampl_sum = 0;
+    for (uint32_t i = 0; i < _settings.depth; ++i) {
+        double a = _settings.amplitudeGenerator(i);
+        double scale = _settings.baseGridResolution * (1 << i);
+        const SimplexLayer& layer = _layers[i];
+        for (size_t j = 0; j < count; ++j) {
+            out[j] += layer(Vec2d(x[j] * scale, y[j] * scale)) * a;
+        }
+        ampl_sum += a;
+    }
+    for (size_t j = 0; j < count; ++j) {
+        out[j] = _settings.transformerFunction(out[j] / ampl_sum);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+
+#include <library/vec2.h>
+#include <library/ext_math.h>
+
+#include "arena.h"
+#include "noise.h"
+
+/* Simplex noise: every sample sums the contributions of the three corners of its
+ * triangle in a skewed lattice, instead of blending four square corners. Fewer
+ * corners per octave and no axis-aligned creases. Lattices do not wrap, octaves are
+ * summed in double for either Real */
+class SimplexNoise : public Noise {
+private:
+    struct SimplexLayer {
+        // corners hash through a random permutation, doubled to skip wrapping the sums,
+        // onto a table of random unit gradients
+        std::array<uint8_t, 512> permutation;
+        std::array<Vec2d, 256> gradients;
+
+        void Generate();
+        double operator()(Vec2d p) const;
+    };
+
+public:
+    SimplexNoise() = default;
+
+    Engine GetEngine() const override;
+    void Generate(const Settings& settings) override;
+    double operator()(Vec2<double> p) override;
+    void Sample(const Real* x, const Real* y, Real* out, size_t count) override;
+
+private:
+    Settings _settings;
+    Arena::Plane<SimplexLayer> _layers;
+};
@@ -1,144 +1,1368 @@
 #include "world.h"
 
+#include <library/parallel.h>
+#include <library/profiler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <queue>
 #include <set>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// angular width of the shadow edge, the sun is not a point
+const double SHADOW_PENUMBRA = ExtMath::ToRadian(2);
+
+} // namespace
+
 World::World()
     : _time(0) 
 {}
 
+namespace {
+
+// resolution gained by every Refine
+const uint32_t REFINEMENT = 4;
+
+// noise fields created by GenerateNoise, one unit each
+enum NoiseField {
+    HEIGHT_NOISE = 0,
+    TEMPERATURE_NOISE,
+    HUMIDITY_NOISE,
+    WARP_NOISE_X,
+    WARP_NOISE_Y,
+    NOISE_FIELDS,
+};
+
+const int DX[8] = {-1, 1, 0, 0, -1, 1, -1, 1};
+const int DY[8] = {0, 0, -1, 1, -1, -1, 1, 1};
+
+} // namespace
+
+// consecutive stages of the same name are timed as one
+const World::Stage World::STAGES[] = {
+    {"noise", &World::BeginNoise, &World::GenerateNoise},
+    {"warp", &World::BeginWarp, &World::WarpHeightSamples},
+    {"fields", &World::BeginFields, &World::GenerateFields},
+    {"erosion", &World::BeginErosion, &World::ErodeHeights},
+    {"drainage", &World::BeginFlood, &World::SeedFlood},
+    {"drainage", &World::Cells, &World::FloodDepressions},
+    {"drainage", &World::Rows, &World::FindReceivers},
+    {"drainage", &World::BeginAccumulation, &World::AccumulateFlow},
+    {"drainage", &World::Rows, &World::MarkRivers},
+    {"normals", &World::BeginNormals, &World::ComputeNormals},
+    {"occlusion", &World::BeginOcclusion, &World::BuildHeightMips},
+    {"occlusion", &World::Rows, &World::ComputeOcclusion},
+    {"biomes", &World::BeginBiomes, &World::ClassifyBiomes},
+    {"climate", &World::BeginClimate, &World::InitClimate},
+};
+
 void World::Regenerate() {
+    GeneratePass(1, false);
+}
+
+void World::GenerateProgressive(const Settings& settings) {
+    _fullSettings = settings;
+    _passSettingsStale = true;
+    GeneratePass(std::max(1u, settings.previewScale), false);
+}
+
+bool World::Refine(double budgetMs) {
+    if (!_pass.active) {
+        if (_passScale == 1) {
+            return false;
+        }
+        StartPass(std::max(1u, _passScale / REFINEMENT), true);
+    }
+    return AdvancePass(budgetMs);
+}
+
+bool World::Complete() const {
+    return !_pass.active && _passScale == 1;
+}
+
+World::Settings World::PassSettings(uint32_t scale) const {
+    Settings settings = _fullSettings;
+    if (scale == 1) {
+        return settings;
+    }
+    settings.worldSize = Vec2u(std::max(1u, settings.worldSize.x / scale), std::max(1u, settings.worldSize.y / scale));
+    settings.occlusionRadius /= scale;
+    // previews are replaced before the climate would change anything visible
+    settings.climate.enabled = false;
+    return settings;
+}
+
+Noise::Settings World::WarpNoiseSettings() const {
+    const Settings::Warp& warp = _settings.heightWarp;
+    Noise::Settings settings;
+    settings.engine = _settings.heightNoiseSettings.engine;
+    settings.wrapX = _settings.heightNoiseSettings.wrapX;
+    settings.wrapY = _settings.heightNoiseSettings.wrapY;
+    settings.depth = warp.depth;
+    settings.baseGridResolution = warp.baseGridResolution;
+    settings.amplitudeGenerator = [depth = warp.depth](uint32_t x) {
+        return ExtMath::PowInt(2., depth - 1 - x) * 2;
+    };
+    return settings;
+}
+
+void World::GeneratePass(uint32_t scale, bool keepNoise) {
+    StartPass(scale, keepNoise);
+    AdvancePass(std::numeric_limits<double>::infinity());
+}
+
+void World::StartPass(uint32_t scale, bool keepNoise) {
     std::cout << "Generate" << std::endl;
-    _tex.create(_settings.worldSize.x, _settings.worldSize.y);
-
-    _heightNoise.Generate(_settings.heightNoiseSettings);
-    _temperatureNoise.Generate(_settings.temperatureNoiseSettings);
-    _humidityNoise.Generate(_settings.humidityNoiseSettings);
-
-    _map.assign(_settings.worldSize.y + 1, std::vector<Cell>(_settings.worldSize.x + 1));
-    // heights
-    for (uint32_t y = 0; y < _settings.worldSize.y; ++y) {
-        for (uint32_t x = 0; x < _settings.worldSize.x; ++x) {
-            auto& cell = _map[y][x];
-            Vec2d p = Vec2d{x, y} / _settings.worldSize;
-            double height = _heightNoise(p);
-            double is = _settings.islandSize;
-            double island = -10 * (std::pow(p.x * 2 * is - is, 4) + std::pow(p.y * 2 * is - is, 4));
-            cell.height = (height + island);
-            cell.temperature = _temperatureNoise(p);
-            cell.humidity = _humidityNoise(p);
-        }
-    }
-
-    // normals
-    for (uint32_t y = 0; y < _settings.worldSize.y; ++y) {
-        for (uint32_t x = 0; x < _settings.worldSize.x; ++x) {
-            _map[y][x].normal = GetNormal(x, y);
-        }
-    }
-
-    // biomes
-    for (uint32_t y = 0; y < _settings.worldSize.y; ++y) {
-        for (uint32_t x = 0; x < _settings.worldSize.x; ++x) {
-            auto& cell = _map[y][x];
-            double slope = ExtMath::ToDegrees(angle(Vec3d{0, 0, 1}, cell.normal));
-            std::vector<uint32_t> candidates;
-            for (uint32_t i = 0; i < _settings.biomes.size(); ++i) {
-                const auto& candidate = _settings.biomes[i];
-                if (!candidate.heightBounds.Contain(cell.height)) {
-                    continue;
+    if (!_map.empty() && _pixelsStale) {
+        // the finished map stays on screen until the new one is complete, Render shaded it
+        // already unless no frame was drawn since it was finished
+        ShadeMap();
+    }
+
+    if (scale != _passScale || _passSettingsStale) {
+        // a regeneration of the same pass keeps the settings, copies allocate
+        _settings = PassSettings(scale);
+        _warpNoiseSettings = WarpNoiseSettings();
+        _passSettingsStale = false;
+    }
+    _passScale = scale;
+    _cellSpan = static_cast<double>(_fullSettings.worldSize.x) / _settings.worldSize.x;
+    // GenerateFields writes every cell, the stages up to it do not read the map
+    _map.resize(static_cast<size_t>(_settings.worldSize.x + 1) * (_settings.worldSize.y + 1));
+
+    // shadows belong to the old terrain, the first Tick after the pass rebuilds them
+    _horizonValid = false;
+    _shadowsValid = false;
+    _sunVisibility.clear();
+
+    if (!keepNoise && _settings.seed != 0) {
+        ExtMath::SeedRandom(_settings.seed);
+    }
+    _generationTimings.clear();
+    _pass = PassProgress{
+        .active = true,
+        .stage = keepNoise ? 1u : 0u,
+    };
+}
+
+bool World::AdvancePass(double budgetMs) {
+    PROFILE_SCOPE("World::AdvancePass");
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto msSince = [](Clock::time_point t) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+    };
+
+    constexpr size_t STAGE_COUNT = sizeof(STAGES) / sizeof(STAGES[0]);
+    while (_pass.active) {
+        const Stage& stage = STAGES[_pass.stage];
+        const auto sliceStart = Clock::now();
+        if (!_pass.begun) {
+            _pass.units = (this->*stage.begin)();
+            _pass.unit = 0;
+            _pass.runMs = 0;
+            _pass.lastPace = 0;
+            _pass.begun = true;
+        } else {
+            // As many units as fit into half the budget left at the slower of the stage's mean
+            // pace and the last slice's, units of a stage vary in cost. Aiming at half lets the
+            // next slice measure again before the rest is spent, so a unit twice as slow as the
+            // pace does not overrun. The first slice of a stage is a single unit that measures the pace
+            uint64_t count = _pass.units - _pass.unit;
+            if (std::isfinite(budgetMs)) {
+                const double left = budgetMs - msSince(start);
+                const double pace = _pass.unit ? std::max(_pass.runMs / _pass.unit, _pass.lastPace) : 0;
+                count = pace > 0 ? std::clamp<uint64_t>(left / (2 * pace), 1, count) : 1;
+            }
+            (this->*stage.run)(_pass.unit, _pass.unit + count);
+            const double ms = msSince(sliceStart);
+            _pass.unit += count;
+            _pass.runMs += ms;
+            _pass.lastPace = ms / count;
+        }
+
+        const double ms = msSince(sliceStart);
+        if (!_generationTimings.empty() && std::strcmp(_generationTimings.back().name, stage.name) == 0) {
+            _generationTimings.back().ms += ms;
+        } else {
+            _generationTimings.push_back(StageTiming{
+                .name = stage.name,
+                .ms = ms,
+            });
+        }
+
+        if (_pass.unit == _pass.units) {
+            _pass.begun = false;
+            if (++_pass.stage == STAGE_COUNT) {
+                _pass.active = false;
+                _pixelsStale = true;
+                return true;
+            }
+        }
+        if (msSince(start) >= budgetMs) {
+            break;
+        }
+    }
+    return false;
+}
+
+uint64_t World::Rows() {
+    return _settings.worldSize.y;
+}
+
+uint64_t World::Cells() {
+    return static_cast<uint64_t>(_settings.worldSize.x) * _settings.worldSize.y;
+}
+
+const std::vector<World::StageTiming>& World::GenerationTimings() const {
+    return _generationTimings;
+}
+
+double World::Height(uint32_t x, uint32_t y) const {
+    return _map[static_cast<size_t>(y) * (_settings.worldSize.x + 1) + x].height;
+}
+
+Vec3d World::Normal(uint32_t x, uint32_t y) const {
+    const auto n = _normals.get(static_cast<size_t>(y) * _settings.worldSize.x + x);
+    return Vec3d(n.x, n.y, n.z);
+}
+
+uint64_t World::BeginNoise() {
+    return NOISE_FIELDS;
+}
+
+void World::GenerateNoise(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::GenerateNoise");
+    // noises of the engine are kept, so their tables are reused
+    auto generate = [&](std::unique_ptr<Noise>& noise, const Noise::Settings& settings) {
+        if (!noise || noise->GetEngine() != settings.engine) {
+            noise = Noise::Create(settings.engine);
+        }
+        noise->Generate(settings);
+    };
+    const Settings::Warp& warp = _settings.heightWarp;
+    for (uint64_t field = first; field < last; ++field) {
+        switch (field) {
+        case HEIGHT_NOISE:
+            generate(_heightNoise, _settings.heightNoiseSettings);
+            break;
+        case TEMPERATURE_NOISE:
+            generate(_temperatureNoise, _settings.temperatureNoiseSettings);
+            break;
+        case HUMIDITY_NOISE:
+            generate(_humidityNoise, _settings.humidityNoiseSettings);
+            break;
+        case WARP_NOISE_X:
+        case WARP_NOISE_Y: {
+            auto& noise = _warpNoise[field - WARP_NOISE_X];
+            if (warp.strength == 0) {
+                noise.reset();
+            } else {
+                generate(noise, _warpNoiseSettings);
+            }
+            break;
+        }
+        }
+    }
+}
+
+uint64_t World::BeginWarp() {
+    const size_t n = static_cast<size_t>(_settings.worldSize.x) * _settings.worldSize.y;
+    _sampleX.resize(n);
+    _sampleY.resize(n);
+    _sampleValues.resize(n);
+    if (!_warpNoise[0]) {
+        _sampleOffsets.clear();
+        return 0;
+    }
+    _sampleOffsets.resize(n);
+    return Rows();
+}
+
+void World::WarpHeightSamples(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::WarpHeightSamples");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+
+    // Bands of rows are the tiles: the coordinates of a band, both offset fields and the
+    // warped coordinates each take one batch, in the buffers GenerateFields samples from
+    const Real strength = _settings.heightWarp.strength;
+    const bool wrapX = _settings.heightNoiseSettings.wrapX;
+    const bool wrapY = _settings.heightNoiseSettings.wrapY;
+    Parallel::For(first, last, 16, [&](size_t y0, size_t y1) {
+        const size_t begin = y0 * w;
+        const size_t count = (y1 - y0) * w;
+        Real* xs = &_sampleX[begin];
+        Real* ys = &_sampleY[begin];
+        Real* offsetX = &_sampleValues[begin];
+        Real* offsetY = &_sampleOffsets[begin];
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                _sampleX[y * w + x] = static_cast<Real>(x) / w;
+                _sampleY[y * w + x] = static_cast<Real>(y) / h;
+            }
+        }
+        _warpNoise[0]->Sample(xs, ys, offsetX, count);
+        _warpNoise[1]->Sample(xs, ys, offsetY, count);
+        for (size_t i = 0; i < count; ++i) {
+            Real x = xs[i] + offsetX[i] * strength;
+            Real y = ys[i] + offsetY[i] * strength;
+            // the lattices end at the map edges, unless they repeat
+            xs[i] = wrapX ? x - std::floor(x) : std::clamp<Real>(x, 0, 1);
+            ys[i] = wrapY ? y - std::floor(y) : std::clamp<Real>(y, 0, 1);
+        }
+    });
+}
+
+uint64_t World::BeginFields() {
+    const size_t n = static_cast<size_t>(_settings.worldSize.x) * _settings.worldSize.y;
+    _temperature.resize(n);
+    _humidity.resize(n);
+    return Rows();
+}
+
+void World::GenerateFields(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::GenerateFields");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+
+    // every field is sampled a band of rows per batch
+    const bool warped = !_sampleOffsets.empty();
+    Parallel::For(first, last, 16, [&](size_t y0, size_t y1) {
+        const size_t begin = y0 * w;
+        const size_t count = (y1 - y0) * w;
+        Real* xs = &_sampleX[begin];
+        Real* ys = &_sampleY[begin];
+        Real* values = &_sampleValues[begin];
+        auto latticeSamples = [&] {
+            for (size_t y = y0; y < y1; ++y) {
+                for (uint32_t x = 0; x < w; ++x) {
+                    _sampleX[y * w + x] = static_cast<Real>(x) / w;
+                    _sampleY[y * w + x] = static_cast<Real>(y) / h;
                 }
-                if (!candidate.slopeBounds.Contain(slope)) {
-                    continue;
+            }
+        };
+
+        // WarpHeightSamples left the warped coordinates, the island keeps the cell's own
+        if (!warped) {
+            latticeSamples();
+        }
+        _heightNoise->Sample(xs, ys, values, count);
+        const double is = _settings.islandSize;
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                Vec2d p(static_cast<double>(x) / w, static_cast<double>(y) / h);
+                double island = -10 * (ExtMath::PowInt(p.x * 2 * is - is, 4) + ExtMath::PowInt(p.y * 2 * is - is, 4));
+                MapCell(x, y).height = _sampleValues[y * w + x] + island;
+            }
+            // the spare column and row stay at sea level
+            MapCell(w, y) = Cell{};
+            if (y + 1 == h) {
+                for (uint32_t x = 0; x <= w; ++x) {
+                    MapCell(x, h) = Cell{};
                 }
-                if (!candidate.humidityBounds.Contain(cell.humidity)) {
-                    continue;
+            }
+        }
+
+        if (warped) {
+            latticeSamples();
+        }
+        _temperatureNoise->Sample(xs, ys, values, count);
+        std::copy(values, values + count, &_temperature[begin]);
+        _humidityNoise->Sample(xs, ys, values, count);
+        std::copy(values, values + count, &_humidity[begin]);
+    });
+}
+
+uint64_t World::BeginErosion() {
+    const Settings::Erosion& settings = _settings.erosion;
+    if (settings.iterations == 0) {
+        return 0;
+    }
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    const size_t n = static_cast<size_t>(w) * h;
+
+    ErosionBuffers& e = _erosion;
+    e.height.resize(n);
+    e.water.resize(n);
+    e.sediment.resize(n);
+    e.concentration.resize(n);
+    e.slope.resize(n);
+    for (auto& flux : e.flux) {
+        flux.resize(n);
+    }
+    // the rows loaded from the map, of both passes of every step, then written back to the map
+    return (2 * static_cast<uint64_t>(settings.iterations) + 2) * h;
+}
+
+void World::ErodeHeights(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::ErodeHeights");
+    const Settings::Erosion& settings = _settings.erosion;
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    ErosionBuffers& e = _erosion;
+
+    const float rain = settings.rain;
+    const float keptWater = 1 - settings.evaporation;
+    const float capacity = settings.capacity;
+    const float erosionRate = settings.erosionRate;
+    const float depositionRate = settings.depositionRate;
+
+    // outflow towards lower water surfaces, at most half the water to damp oscillation
+    auto outflow = [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                const size_t i = y * w + x;
+                const float water = e.water[i] + rain;
+                const float surface = e.height[i] + water;
+                const size_t neighbours[4] = {i - 1, i + 1, i - w, i + w};
+                const bool inside[4] = {x > 0, x + 1 < w, y > 0, y + 1 < h};
+                float drops[4];
+                float total = 0;
+                float slope = 0;
+                for (int k = 0; k < 4; ++k) {
+                    const size_t j = inside[k] ? neighbours[k] : i;
+                    drops[k] = std::max(surface - e.height[j] - e.water[j], 0.f);
+                    total += drops[k];
+                    slope = std::max(slope, e.height[i] - e.height[j]);
+                }
+                const float scale = total > 0 ? std::min(water * 0.5f, total * 0.5f) / total : 0;
+                for (int k = 0; k < 4; ++k) {
+                    e.flux[k][i] = drops[k] * scale;
+                }
+                // dry cells carry no sediment, "rain": 0 leaves every cell dry at first
+                e.concentration[i] = water > 0 ? e.sediment[i] / water : 0.f;
+                e.slope[i] = slope;
+            }
+        }
+    };
+
+    // gather the inflow, then erode or deposit towards the capacity of the flow
+    auto settle = [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                const size_t i = y * w + x;
+                const float outflow = e.flux[0][i] + e.flux[1][i] + e.flux[2][i] + e.flux[3][i];
+                float water = e.water[i] + rain - outflow;
+                float sediment = e.sediment[i] - outflow * e.concentration[i];
+                // the neighbour at -x sends its +x flux here, and so on
+                if (x > 0) {
+                    water += e.flux[1][i - 1];
+                    sediment += e.flux[1][i - 1] * e.concentration[i - 1];
+                }
+                if (x + 1 < w) {
+                    water += e.flux[0][i + 1];
+                    sediment += e.flux[0][i + 1] * e.concentration[i + 1];
+                }
+                if (y > 0) {
+                    water += e.flux[3][i - w];
+                    sediment += e.flux[3][i - w] * e.concentration[i - w];
+                }
+                if (y + 1 < h) {
+                    water += e.flux[2][i + w];
+                    sediment += e.flux[2][i + w] * e.concentration[i + w];
+                }
+
+                float height = e.height[i];
+                const float carried = capacity * outflow * e.slope[i];
+                if (sediment > carried) {
+                    const float deposited = (sediment - carried) * depositionRate;
+                    height += deposited;
+                    sediment -= deposited;
+                } else {
+                    // no deeper than the lowest neighbour, or pits fill with standing water
+                    const float eroded = std::min((carried - sediment) * erosionRate, e.slope[i] * 0.5f);
+                    height -= eroded;
+                    sediment += eroded;
+                }
+
+                if (height < 0) {
+                    // the sea takes the water and everything it carries settles
+                    height += sediment;
+                    water = 0;
+                    sediment = 0;
                 }
-                if (!candidate.temperatureBounds.Contain(cell.temperature)) {
+                e.height[i] = height;
+                e.water[i] = water * keptWater;
+                e.sediment[i] = sediment;
+            }
+        }
+    };
+
+    auto load = [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                const size_t i = y * w + x;
+                e.height[i] = GetHeight(x, y);
+                e.water[i] = 0;
+                e.sediment[i] = 0;
+            }
+        }
+    };
+
+    auto writeBack = [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                const size_t i = y * w + x;
+                MapCell(x, y).height = e.height[i] + e.sediment[i];
+            }
+        }
+    };
+
+    // Every step is two passes in which a cell writes only its own entries and reads its
+    // neighbours', so rows split freely between threads and the result does not depend on
+    // their number. The map edges are walls, water leaves through the sea. The first pass loads
+    // the map, a pass is finished before any row of the next one starts, the units run in order
+    while (first < last) {
+        const uint64_t pass = first / h;
+        const uint64_t passEnd = std::min(last, (pass + 1) * h);
+        const size_t y0 = first - pass * h;
+        const size_t y1 = passEnd - pass * h;
+        if (pass == 0) {
+            load(y0, y1);
+        } else if (pass == 2 * static_cast<uint64_t>(settings.iterations) + 1) {
+            writeBack(y0, y1);
+        } else {
+            if (pass % 2 == 1) {
+                Parallel::For(y0, y1, 16, outflow);
+            } else {
+                Parallel::For(y0, y1, 16, settle);
+            }
+        }
+        first = passEnd;
+    }
+}
+
+uint64_t World::BeginFlood() {
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    const size_t n = static_cast<size_t>(w) * h;
+    _waterLevel.resize(n);
+    _receivers.resize(n);
+    _flow.resize(n);
+    _rivers.resize(n);
+    _drainageOrder.clear();
+    _drainageOrder.reserve(n);
+
+    FloodState& f = _flood;
+    f.closed.resize(n);
+    // every cell enters the queues once at most, so maps of this size never grow them
+    f.open.clear();
+    f.open.reserve(n);
+    f.level.clear();
+    f.level.reserve(n);
+    f.levelHead = 0;
+    return Rows();
+}
+
+void World::SeedFlood(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::SeedFlood");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+
+    // Priority flood: cells are taken lowest level first starting from the sea and the map
+    // edges, so depressions fill to their spill point. Cells at or below the current level
+    // skip the heap through a FIFO, which makes flats and lakes linear time
+    FloodState& f = _flood;
+    for (uint32_t y = first; y < last; ++y) {
+        for (uint32_t x = 0; x < w; ++x) {
+            uint32_t i = y * w + x;
+            // levels of cells not yet flooded are their heights
+            float hi = GetHeight(x, y);
+            _waterLevel[i] = hi;
+            _flow[i] = 1;
+            f.closed[i] = 0;
+            if (hi < 0) {
+                // the sea is the lowest level there is
+                _waterLevel[i] = 0;
+                f.level.push_back(i);
+            } else if (x == 0 || y == 0 || x + 1 == w || y + 1 == h) {
+                f.open.emplace(hi, i);
+            } else {
+                continue;
+            }
+            f.closed[i] = 1;
+            _receivers[i] = i;
+        }
+    }
+}
+
+void World::FloodDepressions(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::FloodDepressions");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    FloodState& f = _flood;
+    for (uint64_t taken = first; taken < last; ++taken) {
+        uint32_t c;
+        if (f.levelHead < f.level.size()) {
+            c = f.level[f.levelHead++];
+        } else {
+            f.level.clear();
+            f.levelHead = 0;
+            c = f.open.top().second;
+            f.open.pop();
+        }
+        _drainageOrder.push_back(c);
+        const float surface = _waterLevel[c];
+        const int cx = c % w;
+        const int cy = c / w;
+        for (int k = 0; k < 8; ++k) {
+            const int nx = cx + DX[k];
+            const int ny = cy + DY[k];
+            if (nx < 0 || ny < 0 || nx >= static_cast<int>(w) || ny >= static_cast<int>(h)) {
+                continue;
+            }
+            const uint32_t j = ny * w + nx;
+            if (f.closed[j]) {
+                continue;
+            }
+            f.closed[j] = 1;
+            // the flood parent drains flats and filled depressions towards the spill point
+            _receivers[j] = c;
+            const float hj = _waterLevel[j];
+            if (hj <= surface) {
+                _waterLevel[j] = surface;
+                f.level.push_back(j);
+            } else {
+                f.open.emplace(hj, j);
+            }
+        }
+    }
+}
+
+void World::FindReceivers(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::FindReceivers");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+
+    // D8: the steepest strictly lower neighbour of the filled surface. The flood takes cells
+    // in nondecreasing level, so every receiver precedes its donors in _drainageOrder
+    const float DIAGONAL = 1 / std::sqrt(2.f);
+    Parallel::For(first, last, 16, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                const uint32_t i = y * w + x;
+                if (_receivers[i] == i) {
                     continue;
                 }
-                candidates.push_back(i);
+                float steepest = 0;
+                for (int k = 0; k < 8; ++k) {
+                    const int nx = x + DX[k];
+                    const int ny = y + DY[k];
+                    if (nx < 0 || ny < 0 || nx >= static_cast<int>(w) || ny >= static_cast<int>(h)) {
+                        continue;
+                    }
+                    const uint32_t j = ny * w + nx;
+                    const float slope = (_waterLevel[i] - _waterLevel[j]) * (k < 4 ? 1 : DIAGONAL);
+                    if (slope > steepest) {
+                        steepest = slope;
+                        _receivers[i] = j;
+                    }
+                }
             }
-            assert(!candidates.empty());
-            cell.biome = *(candidates.begin());
+        }
+    });
+}
+
+uint64_t World::BeginAccumulation() {
+    return _drainageOrder.size();
+}
+
+void World::AccumulateFlow(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::AccumulateFlow");
+    // donors before receivers, unit k is the k-th cell from the end of the order
+    const size_t n = _drainageOrder.size();
+    for (uint64_t k = first; k < last; ++k) {
+        const uint32_t c = _drainageOrder[n - 1 - k];
+        if (_receivers[c] != c) {
+            _flow[_receivers[c]] += _flow[c];
+        }
+    }
+}
+
+void World::MarkRivers(uint64_t first, uint64_t last) {
+    const uint32_t w = _settings.worldSize.x;
+    const float riverCells = _settings.riverFlow * w * _settings.worldSize.y;
+    for (uint32_t y = first; y < last; ++y) {
+        for (uint32_t x = 0; x < w; ++x) {
+            const size_t i = static_cast<size_t>(y) * w + x;
+            _rivers[i] = _flow[i] >= riverCells && GetHeight(x, y) >= 0;
+        }
+    }
+}
+
+uint64_t World::BeginNormals() {
+    const uint32_t w = _settings.worldSize.x;
+    _normals.resize(static_cast<size_t>(w) * _settings.worldSize.y);
+    return Rows();
+}
+
+void World::ComputeNormals(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::ComputeNormals");
+    const uint32_t w = _settings.worldSize.x;
+    for (uint32_t y = first; y < last; ++y) {
+        // cross product of the (1, 0, dh/dx) and (0, 1, dh/dy) tangents
+        auto row = _normals.span(static_cast<size_t>(y) * w, w);
+        for (uint32_t x = 0; x < w; ++x) {
+            double h = GetHeight(x, y);
+            row.x[x] = h - GetHeight(x + 1, y);
+            row.y[x] = h - GetHeight(x, y + 1);
+            row.z[x] = _cellSpan;
+        }
+        normalize(row);
+    }
+}
+
+uint64_t World::BeginOcclusion() {
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    const double radius = _settings.occlusionRadius;
+    _skyVisibility.resize(static_cast<size_t>(w) * h);
+    _heightMipSizes.clear();
+    if (radius < 1) {
+        return 0;
+    }
+
+    // Far samples read coarser levels of a max pyramid, so a few samples per direction
+    // see every ridge within the radius. Taking the max errs towards darker
+    _heightMipSizes.push_back(Vec2u(w, h));
+    while ((2u << _heightMipSizes.size()) <= radius) {
+        Vec2u prev = _heightMipSizes.back();
+        _heightMipSizes.push_back(Vec2u((prev.x + 1) / 2, (prev.y + 1) / 2));
+    }
+    uint64_t rows = 0;
+    for (size_t k = 0; k < _heightMipSizes.size(); ++k) {
+        if (_heightMips.size() == k) {
+            _heightMips.emplace_back();
+        }
+        const Vec2u size = _heightMipSizes[k];
+        _heightMips[k].resize(static_cast<size_t>(size.x) * size.y);
+        rows += size.y;
+    }
+
+    // Distances grow by half each step, sampled at the level whose cells are about half as wide.
+    // x + floor(offset) == floor(x + offset) for integer x, so the offsets are precomputed
+    for (int i = 0; i < OCCLUSION_DIRECTIONS; ++i) {
+        auto& samples = _occlusionSamples[i];
+        samples.clear();
+        double a = 2 * ExtMath::PI * i / OCCLUSION_DIRECTIONS;
+        for (double d = 1; d <= radius; d = std::max(d + 1, std::floor(d * 1.5))) {
+            uint32_t level = 0;
+            while (level + 1 < _heightMipSizes.size() && (2u << level) <= d / 2) {
+                ++level;
+            }
+            samples.push_back(OcclusionSample{
+                static_cast<int32_t>(std::floor(std::cos(a) * d)),
+                static_cast<int32_t>(std::floor(std::sin(a) * d)),
+                static_cast<float>(1 / (d * _cellSpan)),
+                level});
+        }
+    }
+    return rows;
+}
+
+void World::BuildHeightMips(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::BuildHeightMips");
+    // the levels' rows one after another, a level reads only rows of the finer one before it
+    uint64_t levelBegin = 0;
+    for (size_t k = 0; k < _heightMipSizes.size() && first < last; ++k) {
+        const Vec2u size = _heightMipSizes[k];
+        const uint64_t levelEnd = levelBegin + size.y;
+        auto& level = _heightMips[k];
+        for (; first < std::min(last, levelEnd); ++first) {
+            const uint32_t y = first - levelBegin;
+            if (k == 0) {
+                for (uint32_t x = 0; x < size.x; ++x) {
+                    level[static_cast<size_t>(y) * size.x + x] = GetHeight(x, y);
+                }
+                continue;
+            }
+            const Vec2u prev = _heightMipSizes[k - 1];
+            const auto& src = _heightMips[k - 1];
+            for (uint32_t x = 0; x < size.x; ++x) {
+                uint32_t x1 = std::min(2 * x + 1, prev.x - 1);
+                uint32_t y1 = std::min(2 * y + 1, prev.y - 1);
+                level[static_cast<size_t>(y) * size.x + x] = std::max(
+                    std::max(src[2 * y * prev.x + 2 * x], src[2 * y * prev.x + x1]),
+                    std::max(src[y1 * prev.x + 2 * x], src[y1 * prev.x + x1]));
+            }
+        }
+        levelBegin = levelEnd;
+    }
+}
+
+void World::ComputeOcclusion(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::ComputeOcclusion");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    if (_heightMipSizes.empty()) {
+        // occlusion is off, the sky is open everywhere
+        std::fill(_skyVisibility.begin() + first * w, _skyVisibility.begin() + last * w, 255);
+        return;
+    }
+    Parallel::For(first, last, 8, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                float height = _heightMips[0][y * w + x];
+                float visible = 0;
+                for (const auto& direction : _occlusionSamples) {
+                    float maxSlope = 0;
+                    for (const OcclusionSample& sample : direction) {
+                        int64_t sx = static_cast<int64_t>(x) + sample.dx;
+                        int64_t sy = static_cast<int64_t>(y) + sample.dy;
+                        if (sx < 0 || sy < 0 || sx >= w || sy >= h) {
+                            break;
+                        }
+                        const Vec2u& size = _heightMipSizes[sample.level];
+                        size_t i = static_cast<size_t>(sy >> sample.level) * size.x + (sx >> sample.level);
+                        maxSlope = std::max(maxSlope, (_heightMips[sample.level][i] - height) * sample.inverseDistance);
+                    }
+                    // the sky above the horizon, 1 - sin(elevation)
+                    visible += 1 - maxSlope / std::sqrt(1 + maxSlope * maxSlope);
+                }
+                _skyVisibility[y * w + x] = visible / OCCLUSION_DIRECTIONS * 255;
+            }
+        }
+    });
+}
+
+uint32_t World::ClassifyCell(double height, double normalZ, double lakeDepth, bool river, double temperature, double humidity) const {
+    const auto& biomes = _settings.biomes;
+    // first matching biome wins
+    uint32_t biome = 0;
+    for (; biome < biomes.size(); ++biome) {
+        const auto& candidate = biomes[biome];
+        if (candidate.heightBounds.Contain(height) &&
+            candidate.normalZBounds.Contain(normalZ) &&
+            candidate.lakeDepthBounds.Contain(lakeDepth) &&
+            (!candidate.river || river) &&
+            candidate.humidityBounds.Contain(humidity) &&
+            candidate.temperatureBounds.Contain(temperature)) {
+            break;
         }
     }
+    assert(biome < biomes.size());
+    return biome;
+}
+
+uint16_t World::ClimateRank(float temperature, float humidity) const {
+    // Values with equal ranks compare the same against every bound: the rank counts the
+    // thresholds below the value, doubled, plus one if the value equals the next threshold.
+    // There are a few dozen thresholds, a branch-free count beats a binary search
+    auto rank = [](const double* thresholds, uint32_t count, double v) {
+        uint32_t below = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            below += thresholds[i] < v;
+        }
+        return static_cast<uint16_t>(2 * below + (below < count && thresholds[below] == v));
+    };
+    return rank(_temperatureThresholds.data(), _temperatureThresholds.size(), temperature) << 8 |
+           rank(_humidityThresholds.data(), _humidityThresholds.size(), humidity);
+}
+
+void World::BuildRankBrackets(const Arena::Plane<double>& thresholds, Arena::Plane<RankBracket>& brackets) {
+    const double inf = std::numeric_limits<double>::infinity();
+    brackets.resize(2 * thresholds.size() + 1);
+    for (size_t rank = 0; rank < brackets.size(); ++rank) {
+        const size_t next = rank / 2;
+        brackets[rank].lower = next > 0 ? thresholds[next - 1] : -inf;
+        brackets[rank].upper = next < thresholds.size() ? thresholds[next] : inf;
+        brackets[rank].equal = rank & 1;
+    }
+}
+
+uint64_t World::BeginBiomes() {
+    _changedBiomes.clear();
+    return Rows();
+}
+
+void World::ClassifyBiomes(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::ClassifyBiomes");
+    const uint32_t w = _settings.worldSize.x;
+    for (uint32_t y = first; y < last; ++y) {
+        const size_t row = static_cast<size_t>(y) * w;
+        const Real* normalZ = _normals.z.data() + row;
+        const float* waterLevel = _waterLevel.data() + row;
+        const uint8_t* rivers = _rivers.data() + row;
+        const float* temperature = _temperature.data() + row;
+        const float* humidity = _humidity.data() + row;
+        for (uint32_t x = 0; x < w; ++x) {
+            auto& cell = MapCell(x, y);
+            cell.biome = ClassifyCell(cell.height, normalZ[x], waterLevel[x] - cell.height, rivers[x], temperature[x], humidity[x]);
+        }
+    }
+}
+
+void World::UpdateBiomes() {
+    PROFILE_SCOPE("World::UpdateBiomes");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    _changedBiomes.clear();
+    if (_climateRanks.empty() && !_reclassifyAll) {
+        // the fields never change without the climate
+        return;
+    }
+
+    // fixed bands rather than Parallel::For chunks keep the list order independent of the threads
+    constexpr uint32_t BAND_ROWS = 32;
+    const uint32_t bands = (h + BAND_ROWS - 1) / BAND_ROWS;
+    _changedBands.resize(bands);
+    Parallel::For(0, bands, 1, [&](size_t b0, size_t b1) {
+        for (size_t band = b0; band < b1; ++band) {
+            auto& changed = _changedBands[band];
+            changed.clear();
+            const uint32_t yEnd = std::min<uint32_t>(h, (band + 1) * BAND_ROWS);
+            for (uint32_t y = band * BAND_ROWS; y < yEnd; ++y) {
+                for (uint32_t x = 0; x < w; ++x) {
+                    const size_t i = static_cast<size_t>(y) * w + x;
+                    const double temperature = _temperature[i];
+                    const double humidity = _humidity[i];
+                    if (!_reclassifyAll) {
+                        const uint16_t rank = _climateRanks[i];
+                        const RankBracket& t = _temperatureBrackets[rank >> 8];
+                        const RankBracket& u = _humidityBrackets[rank & 0xff];
+                        // strictly inside the bracket, or on its upper end for odd ranks
+                        const bool same = (t.lower < temperature) & (temperature <= t.upper) & ((temperature == t.upper) == t.equal) &
+                                          (u.lower < humidity) & (humidity <= u.upper) & ((humidity == u.upper) == u.equal);
+                        if (same) {
+                            continue;
+                        }
+                        _climateRanks[i] = ClimateRank(temperature, humidity);
+                    }
+                    auto& cell = MapCell(x, y);
+                    const uint32_t biome = ClassifyCell(cell.height, _normals.z[i], _waterLevel[i] - cell.height, _rivers[i], temperature, humidity);
+                    if (biome != cell.biome) {
+                        cell.biome = biome;
+                        changed.push_back(i);
+                    }
+                }
+            }
+        }
+    });
+    for (const auto& changed : _changedBands) {
+        _changedBiomes.insert(_changedBiomes.end(), changed.begin(), changed.end());
+    }
+}
+
+const std::vector<uint32_t>& World::ChangedBiomes() const {
+    return _changedBiomes;
+}
+
+uint64_t World::BeginClimate() {
+    const Settings::Climate& settings = _settings.climate;
+    _climateTime = 0;
+    _climateRanks.clear();
+    _reclassifyAll = false;
+    if (!settings.enabled) {
+        return 0;
+    }
+    const size_t n = static_cast<size_t>(_settings.worldSize.x) * _settings.worldSize.y;
+
+    _temperatureThresholds.clear();
+    _humidityThresholds.clear();
+    for (const auto& biome : _settings.biomes) {
+        _temperatureThresholds.push_back(biome.temperatureBounds.min);
+        _temperatureThresholds.push_back(biome.temperatureBounds.max);
+        _humidityThresholds.push_back(biome.humidityBounds.min);
+        _humidityThresholds.push_back(biome.humidityBounds.max);
+    }
+    for (auto* thresholds : {&_temperatureThresholds, &_humidityThresholds}) {
+        std::sort(thresholds->begin(), thresholds->end());
+        thresholds->erase(std::unique(thresholds->begin(), thresholds->end()), thresholds->end());
+        _reclassifyAll |= thresholds->size() > MAX_RANKED_THRESHOLDS;
+    }
+    if (_reclassifyAll) {
+        std::cerr << "more than " << MAX_RANKED_THRESHOLDS << " distinct biome temperature or humidity bounds, "
+                  << "every cell is reclassified on climate updates" << std::endl;
+    } else {
+        BuildRankBrackets(_temperatureThresholds, _temperatureBrackets);
+        BuildRankBrackets(_humidityThresholds, _humidityBrackets);
+        _climateRanks.resize(n);
+    }
+
+    ClimateBuffers& c = _climate;
+    for (int k = 0; k < 3; ++k) {
+        c.normal[k].resize(n);
+    }
+    c.heating.resize(n);
+    c.cooling.resize(n);
+    c.equilibrium.resize(n);
+    c.evaporation.resize(n);
+    c.baseHumidity.resize(n);
+    c.nextTemperature.resize(n);
+    c.nextHumidity.resize(n);
+    return Rows();
+}
+
+void World::InitClimate(uint64_t first, uint64_t last) {
+    PROFILE_SCOPE("World::InitClimate");
+    const Settings::Climate& settings = _settings.climate;
+    const uint32_t w = _settings.worldSize.x;
+    ClimateBuffers& c = _climate;
+    const size_t begin = first * w;
+    const size_t end = last * w;
+    for (size_t i = begin; i < end && !_reclassifyAll; ++i) {
+        _climateRanks[i] = ClimateRank(_temperature[i], _humidity[i]);
+    }
+    std::copy(_normals.x.begin() + begin, _normals.x.begin() + end, c.normal[0].begin() + begin);
+    std::copy(_normals.y.begin() + begin, _normals.y.begin() + end, c.normal[1].begin() + begin);
+    std::copy(_normals.z.begin() + begin, _normals.z.begin() + end, c.normal[2].begin() + begin);
+    std::copy(_humidity.begin() + begin, _humidity.begin() + end, c.baseHumidity.begin() + begin);
+    for (uint32_t y = first; y < last; ++y) {
+        for (uint32_t x = 0; x < w; ++x) {
+            const size_t i = static_cast<size_t>(y) * w + x;
+            const double height = GetHeight(x, y);
+            // the sea and lakes
+            const bool water = _waterLevel[i] > height;
+            c.heating[i] = water ? settings.waterHeating : 1;
+            c.cooling[i] = water ? settings.waterCooling : settings.cooling;
+            c.equilibrium[i] = _temperature[i] - settings.lapseRate * std::max(0., height);
+            c.evaporation[i] = water ? settings.evaporation : 0;
+        }
+    }
+}
+
+void World::StepClimate() {
+    PROFILE_SCOPE("World::StepClimate");
+    const Settings::Climate& settings = _settings.climate;
+    if (!settings.enabled || _climate.heating.empty()) {
+        return;
+    }
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    ClimateBuffers& c = _climate;
+
+    const float sunX = _sunLight.x;
+    const float sunY = _sunLight.y;
+    const float sunZ = _sunLight.z;
+    const float insolation = settings.insolation;
+    // max(0, cos) of the sun over a day averages 1 / pi on flat ground
+    const float dailyMean = 1 / ExtMath::PI;
+    const float quarterDiffusion = settings.diffusion / 4;
+    const float keepDiffusion = 1 - settings.diffusion;
+    const float humidityRelaxation = settings.humidityRelaxation;
+
+    // Humidity moves semi-Lagrangian with the wind: the air arriving at a cell left from
+    // cell - wind, sampled bilinearly with the same weights everywhere
+    const double fromX = -settings.wind.x;
+    const double fromY = -settings.wind.y;
+    const int offsetX = std::floor(fromX);
+    const int offsetY = std::floor(fromY);
+    const float fx = fromX - offsetX;
+    const float fy = fromY - offsetY;
+    const float w00 = (1 - fx) * (1 - fy);
+    const float w10 = fx * (1 - fy);
+    const float w01 = (1 - fx) * fy;
+    const float w11 = fx * fy;
+    auto clampX = [&](int64_t x) { return static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(x, 0), w - 1)); };
+    auto clampY = [&](int64_t y) { return static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(y, 0), h - 1)); };
+    // cells whose stencils stay inside the row, the edges clamp
+    const uint32_t interiorBegin = std::min<int64_t>(w, std::max(1, -offsetX));
+    const uint32_t interiorEnd = std::max<int64_t>(interiorBegin, std::min<int64_t>(w - 1, static_cast<int64_t>(w) - 1 - offsetX));
+
+    // Row bands are the cache blocks: a band reads its rows plus a halo of one row (and
+    // the wind offset) of the current fields and writes only its own rows of the next ones
+    Parallel::For(0, h, 16, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            const size_t row = y * w;
+            const float* t = &_temperature[row];
+            const float* up = &_temperature[static_cast<size_t>(clampY(static_cast<int64_t>(y) - 1)) * w];
+            const float* down = &_temperature[static_cast<size_t>(clampY(static_cast<int64_t>(y) + 1)) * w];
+            const float* nx = &c.normal[0][row];
+            const float* ny = &c.normal[1][row];
+            const float* nz = &c.normal[2][row];
+            const float* heating = &c.heating[row];
+            const float* cooling = &c.cooling[row];
+            const float* equilibrium = &c.equilibrium[row];
+            float* nextT = &c.nextTemperature[row];
+
+            auto temperatureAt = [&](uint32_t x, uint32_t left, uint32_t right) {
+                const float facing = std::max(0.f, nx[x] * sunX + ny[x] * sunY + nz[x] * sunZ);
+                return t[x] * keepDiffusion + (t[left] + t[right] + up[x] + down[x]) * quarterDiffusion +
+                       insolation * heating[x] * (facing - dailyMean) - cooling[x] * (t[x] - equilibrium[x]);
+            };
+            nextT[0] = temperatureAt(0, 0, clampX(1));
+            uint32_t x = 1;
+#if defined(__SSE2__)
+            // the scalar loop does not vectorize, the compiler cannot rule out aliasing of the planes
+            for (; x + 5 <= w; x += 4) {
+                __m128 center = _mm_loadu_ps(t + x);
+                __m128 neighbours = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(t + x - 1), _mm_loadu_ps(t + x + 1)),
+                                               _mm_add_ps(_mm_loadu_ps(up + x), _mm_loadu_ps(down + x)));
+                __m128 facing = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(nx + x), _mm_set1_ps(sunX)),
+                                                      _mm_mul_ps(_mm_loadu_ps(ny + x), _mm_set1_ps(sunY))),
+                                           _mm_mul_ps(_mm_loadu_ps(nz + x), _mm_set1_ps(sunZ)));
+                facing = _mm_sub_ps(_mm_max_ps(facing, _mm_setzero_ps()), _mm_set1_ps(dailyMean));
+                __m128 next = _mm_add_ps(_mm_mul_ps(center, _mm_set1_ps(keepDiffusion)),
+                                         _mm_mul_ps(neighbours, _mm_set1_ps(quarterDiffusion)));
+                next = _mm_add_ps(next, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(heating + x), _mm_set1_ps(insolation)), facing));
+                next = _mm_sub_ps(next, _mm_mul_ps(_mm_loadu_ps(cooling + x), _mm_sub_ps(center, _mm_loadu_ps(equilibrium + x))));
+                _mm_storeu_ps(nextT + x, next);
+            }
+#endif
+            for (; x + 1 < w; ++x) {
+                nextT[x] = temperatureAt(x, x - 1, x + 1);
+            }
+            if (w > 1) {
+                nextT[w - 1] = temperatureAt(w - 1, w - 2, w - 1);
+            }
+
+            const float* from0 = &_humidity[static_cast<size_t>(clampY(static_cast<int64_t>(y) + offsetY)) * w];
+            const float* from1 = &_humidity[static_cast<size_t>(clampY(static_cast<int64_t>(y) + offsetY + 1)) * w];
+            const float* evaporation = &c.evaporation[row];
+            const float* baseHumidity = &c.baseHumidity[row];
+            float* nextH = &c.nextHumidity[row];
+
+            auto humidityAt = [&](uint32_t x, uint32_t x0, uint32_t x1) {
+                const float arrived = from0[x0] * w00 + from0[x1] * w10 + from1[x0] * w01 + from1[x1] * w11;
+                return arrived + evaporation[x] * (100 - arrived) - humidityRelaxation * (arrived - baseHumidity[x]);
+            };
+            for (uint32_t x = 0; x < interiorBegin; ++x) {
+                nextH[x] = humidityAt(x, clampX(int64_t(x) + offsetX), clampX(int64_t(x) + offsetX + 1));
+            }
+            x = interiorBegin;
+#if defined(__SSE2__)
+            for (; x + 4 <= interiorEnd; x += 4) {
+                const float* a0 = from0 + x + offsetX;
+                const float* a1 = from1 + x + offsetX;
+                __m128 arrived = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a0), _mm_set1_ps(w00)),
+                                                       _mm_mul_ps(_mm_loadu_ps(a0 + 1), _mm_set1_ps(w10))),
+                                            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a1), _mm_set1_ps(w01)),
+                                                       _mm_mul_ps(_mm_loadu_ps(a1 + 1), _mm_set1_ps(w11))));
+                __m128 next = _mm_add_ps(arrived, _mm_mul_ps(_mm_loadu_ps(evaporation + x), _mm_sub_ps(_mm_set1_ps(100), arrived)));
+                next = _mm_sub_ps(next, _mm_mul_ps(_mm_set1_ps(humidityRelaxation), _mm_sub_ps(arrived, _mm_loadu_ps(baseHumidity + x))));
+                _mm_storeu_ps(nextH + x, next);
+            }
+#endif
+            for (; x < interiorEnd; ++x) {
+                nextH[x] = humidityAt(x, x + offsetX, x + offsetX + 1);
+            }
+            for (uint32_t x = interiorEnd; x < w; ++x) {
+                nextH[x] = humidityAt(x, clampX(int64_t(x) + offsetX), clampX(int64_t(x) + offsetX + 1));
+            }
+        }
+    });
+    _temperature.swap(c.nextTemperature);
+    _humidity.swap(c.nextHumidity);
+}
+
+void World::UpdateShadows() {
+    PROFILE_SCOPE("World::UpdateShadows");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    _shadowSun = _sunLight;
+    _shadowsValid = true;
+    _sunVisibility.resize(static_cast<size_t>(w) * h);
+
+    double horizontal = std::hypot(_sunLight.x, _sunLight.y);
+    if (_sunLight.z <= 0 || horizontal < 1e-6) {
+        // below the horizon the sun adds nothing anyway, at the zenith nothing casts a shadow
+        std::fill(_sunVisibility.begin(), _sunVisibility.end(), 255);
+        return;
+    }
+
+    double azimuth = std::atan2(_sunLight.y, _sunLight.x);
+    double azimuthChange = std::abs(std::remainder(azimuth - _horizonAzimuth, 2 * ExtMath::PI));
+    if (!_horizonValid || ExtMath::ToDegrees(azimuthChange) > _settings.shadowUpdateStep) {
+        ComputeHorizon(azimuth);
+    }
+
+    double elevation = std::atan2(_sunLight.z, horizontal);
+    Parallel::For(0, h, 16, [&](size_t y0, size_t y1) {
+        for (size_t i = y0 * w; i < y1 * w; ++i) {
+            double visible = (elevation - _horizon[i]) / SHADOW_PENUMBRA + 0.5;
+            _sunVisibility[i] = std::clamp(visible, 0., 1.) * 255;
+        }
+    });
+}
+
+void World::ComputeHorizon(double azimuth) {
+    PROFILE_SCOPE("World::ComputeHorizon");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    _horizonAzimuth = azimuth;
+    _horizonValid = true;
+    _horizon.resize(static_cast<size_t>(w) * h);
+
+    // Cells are swept in lines running away from the sun along the major axis of the
+    // azimuth, sheared by a rounded offset on the minor axis, so every cell is on exactly
+    // one line. Along a line the horizon of a cell is the tangent to the upper convex hull
+    // of the cells before it, which a stack maintains in amortized O(1)
+    Vec2d towardSun(std::cos(azimuth), std::sin(azimuth));
+    const bool alongY = std::abs(towardSun.y) >= std::abs(towardSun.x);
+    const double major = alongY ? towardSun.y : towardSun.x;
+    const double minor = alongY ? towardSun.x : towardSun.y;
+    const int64_t majorSize = alongY ? h : w;
+    const int64_t minorSize = alongY ? w : h;
+    const double shear = -minor / std::abs(major);
+    const double stepLength = std::sqrt(1 + shear * shear) * _cellSpan;
+
+    const int64_t lastShift = std::llround((majorSize - 1) * shear);
+    const int64_t firstLine = -std::max<int64_t>(0, lastShift);
+    const int64_t lineCount = minorSize + std::abs(lastShift);
+
+    // a stack per line, kept across calls so the sun moving does not allocate
+    if (_horizonHulls.size() < static_cast<size_t>(lineCount)) {
+        _horizonHulls.resize(w + h);
+    }
+    Parallel::For(0, lineCount, 32, [&](size_t l0, size_t l1) {
+        // (distance along the line, height) per line. Lines advance together one step
+        // at a time, so along x the cells are read in memory order
+        for (size_t l = l0; l < l1; ++l) {
+            _horizonHulls[l].clear();
+        }
+        for (int64_t t = 0; t < majorSize; ++t) {
+            int64_t base = firstLine + std::llround(t * shear);
+            int64_t j = major > 0 ? majorSize - 1 - t : t;
+            int64_t begin = std::max<int64_t>(l0, -base);
+            int64_t end = std::min<int64_t>(l1, minorSize - base);
+            for (int64_t l = begin; l < end; ++l) {
+                int64_t m = base + l;
+                uint32_t x = alongY ? m : j;
+                uint32_t y = alongY ? j : m;
+                Vec2d p(t * stepLength, GetHeight(x, y));
+
+                auto& hull = _horizonHulls[l];
+                while (hull.size() >= 2 && cross_prod(hull.back() - hull[hull.size() - 2], p - hull.back()) >= 0) {
+                    hull.pop_back();
+                }
+                float horizon = -ExtMath::PI / 2;
+                if (!hull.empty()) {
+                    double dy = hull.back().y - p.y;
+                    double dx = p.x - hull.back().x;
+                    horizon = _settings.fastMath ? ExtMath::FastAtan2(dy, dx) : std::atan2(dy, dx);
+                }
+                _horizon[static_cast<size_t>(y) * w + x] = horizon;
+                hull.push_back(p);
+            }
+        }
+    });
 }
 
 void World::Generate(const Settings& settings) {
-    _settings = settings;
+    _fullSettings = settings;
+    _passSettingsStale = true;
     Regenerate();
 }
 
 void World::Render(Graphics* gr, Vec2<uint32_t> windowSize) {
-    sf::Image imageTerrain;
-    imageTerrain.create(_settings.worldSize.x, _settings.worldSize.y, sf::Color::Red);
-    for (uint32_t y = 0; y < _settings.worldSize.y; ++y) {
-        for (uint32_t x = 0; x < _settings.worldSize.x; ++x) {
-            auto& cell = _map[y][x];
-            Color fillColor;
-            switch (_renderedLayer) {
-            case Layer::SURFACE: {
-                const auto& biome = _settings.biomes[cell.biome];
-
-                auto lightReflected = [](Vec3d lightSource, Vec3d surfaceNormal, double brightness) {
-                    return std::max(0., dot_prod(lightSource, surfaceNormal)) * brightness;
-                };
+    PROFILE_SCOPE("World::Render");
+    // while a pass is being generated the last finished map is drawn
+    if (!_pass.active) {
+        ShadeMap();
+    }
+    if (_pixels.empty()) {
+        return;
+    }
+
+    {
+        PROFILE_SCOPE("World::Render::Draw");
+        gr->DrawImage(_pixels.data(), _pixelsSize, windowSize * 0.5, windowSize);
+    }
+}
+
+void World::ShadeMap() {
+    PROFILE_SCOPE("World::ShadeMap");
+    const uint32_t w = _settings.worldSize.x;
+    const uint32_t h = _settings.worldSize.y;
+    _pixelsSize = Vec2u(w, h);
+    _pixelsStale = false;
+    _pixels.resize(static_cast<size_t>(w) * h);
+    _rowColors.resize(w);
+    for (auto& plane : _rowPlanes) {
+        plane.resize(w);
+    }
+    _rowSun.resize(w);
+    _rowMoon.resize(w);
+
+    // every row is shaded into scalar planes first, then packed or scaled in bulk
+    for (uint32_t y = 0; y < h; ++y) {
+        PackedColor* row = &_pixels[static_cast<size_t>(y) * w];
+        switch (_renderedLayer) {
+        case Layer::SURFACE: {
+            auto normals = _normals.span(static_cast<size_t>(y) * w, w);
+            dot_prod(normals, Vec3<Real>(_sunLight), _rowSun.data());
+            dot_prod(normals, Vec3<Real>(_moonLight), _rowMoon.data());
+            const uint8_t* sunVisibility = _sunVisibility.empty() ? nullptr : &_sunVisibility[static_cast<size_t>(y) * w];
+            const uint8_t* skyVisibility = &_skyVisibility[static_cast<size_t>(y) * w];
+            float* lights = _rowPlanes[0].data();
+            float* albedos = _rowPlanes[1].data();
+            for (uint32_t x = 0; x < w; ++x) {
+                const auto& biome = _settings.biomes[MapCell(x, y).biome];
+                double sun = _sunBrightness * (sunVisibility ? sunVisibility[x] / 255. : 1.);
+                double ambient = _starBrightness * (skyVisibility[x] / 255.);
+                double directLight = std::max<double>(0, _rowSun[x]) * sun +
+                                     std::max<double>(0, _rowMoon[x]) * _moonBrightness +
+                                     ambient;
+                // light on a flat surface, for water and ice
+                double flatLight = std::max(0., _sunLight.z) * sun +
+                                   std::max(0., _moonLight.z) * _moonBrightness +
+                                   ambient;
 
                 double light;
                 switch (biome.surfaceType) {
                     case Settings::Biome::SurfaceType::NORMAL: {
-                        light = lightReflected(_sunLight, cell.normal, _sunBrightness) +
-                                lightReflected(_moonLight, cell.normal, _moonBrightness) +
-                                _starBrightness;
+                        light = directLight;
                         break;
                     }
                     case Settings::Biome::SurfaceType::WATER: {
-                        light = lightReflected(_sunLight, cell.normal, _sunBrightness) +
-                                lightReflected(_moonLight, cell.normal, _moonBrightness) +
-                                _starBrightness;
-                        light *= std::exp(cell.height * 0.5) * 0.8;
-                        double surfaceLight = lightReflected(_sunLight, Vec3d{0, 0, 1}, _sunBrightness) +
-                                lightReflected(_moonLight, Vec3d{0, 0, 1}, _moonBrightness) +
-                                _starBrightness;
-                        light += surfaceLight * ExtMath::RandomDouble(0.9, 1);
+                        // darker with depth, over the sea the water level is 0
+                        double falloff = (MapCell(x, y).height - _waterLevel[static_cast<size_t>(y) * w + x]) * 0.5;
+                        light = directLight * (_settings.fastMath ? ExtMath::FastExp(falloff) : std::exp(falloff)) * 0.8;
+                        light += flatLight * ExtMath::RandomDouble(0.9, 1);
                         break;
                     }
                     case Settings::Biome::SurfaceType::ICE: {
-                        light = lightReflected(_sunLight, Vec3d{0, 0, 1}, _sunBrightness) +
-                                lightReflected(_moonLight, Vec3d{0, 0, 1}, _moonBrightness) +
-                                _starBrightness;
+                        light = flatLight;
                         break;
                     }
                 }
 
-                fillColor = biome.surfaceColor * light * biome.surfaceAlbedo;
-                break;
-            }
-            case Layer::TEMPERATURE: {
-                double t = cell.temperature / 60 * 255;
-                if (cell.temperature < 0) {
-                    fillColor = Color(255 + t, 255 + t, 255);   
-                } else {
-                    fillColor = Color(255, 255 - t, 255 - t);   
-                }
-                break;
+                _rowColors[x] = biome.surfaceColor;
+                lights[x] = light;
+                albedos[x] = biome.surfaceAlbedo;
             }
-            case Layer::HUMIDITY: {
-                double t = cell.humidity / 100 * 255;
-                fillColor = Color(255 - t, 255 - t, 255);
-                break;
+            // saturated by the light before the albedo darkens it, a surface lit beyond 1
+            // keeps its albedo's share of white
+            ScaleColors(_rowColors.data(), lights, row, w);
+            ScaleColors(row, albedos, row, w);
+            break;
+        }
+        case Layer::TEMPERATURE: {
+            const float* temperatures = &_temperature[static_cast<size_t>(y) * w];
+            for (uint32_t x = 0; x < w; ++x) {
+                double temperature = temperatures[x];
+                float t = temperature / 60 * 255;
+                bool cold = temperature < 0;
+                _rowPlanes[0][x] = cold ? 255 + t : 255;
+                _rowPlanes[1][x] = 255 - std::abs(t);
+                _rowPlanes[2][x] = cold ? 255 : 255 - t;
             }
+            PackColors(_rowPlanes[0].data(), _rowPlanes[1].data(), _rowPlanes[2].data(), row, w);
+            break;
+        }
+        case Layer::HUMIDITY: {
+            const float* humidity = &_humidity[static_cast<size_t>(y) * w];
+            for (uint32_t x = 0; x < w; ++x) {
+                float t = humidity[x] / 100 * 255;
+                _rowPlanes[0][x] = 255 - t;
+                _rowPlanes[1][x] = 255 - t;
+                _rowPlanes[2][x] = 255;
             }
-
-            // fillColor = Color(1, 1, 1) * (cell.humidity / 100 * 255);
-
-            imageTerrain.setPixel(x, y, sf::Color(fillColor.r, fillColor.g, fillColor.b));
+            PackColors(_rowPlanes[0].data(), _rowPlanes[1].data(), _rowPlanes[2].data(), row, w);
+            break;
+        }
         }
     }
-    
-    _tex.update(imageTerrain);
-
-    gr->DrawTexture(_tex, windowSize * 0.5, windowSize);
 }
 
 void World::Tick(double elapsedMs) {
@@ -149,6 +1373,32 @@ void World::Tick(double elapsedMs) {
     double a = (_time / _settings.dayDuration + 0.5) * 2 * ExtMath::PI;
     _sunLight = Vec3d(0, std::sin(a), std::cos(a));
     _moonLight = Vec3d(0, std::sin(a + ExtMath::PI), std::cos(a + ExtMath::PI));
+    if (_pass.active) {
+        // the climate and the shadows wait for the map being generated
+        return;
+    }
+
+    if (_settings.climate.enabled && !_map.empty()) {
+        _climateTime += elapsedMs;
+        uint32_t steps = 0;
+        for (; _climateTime >= _settings.climate.stepMs; ++steps) {
+            if (steps == _settings.climate.maxStepsPerTick) {
+                _climateTime = 0;
+                break;
+            }
+            StepClimate();
+            _climateTime -= _settings.climate.stepMs;
+        }
+        if (steps != 0) {
+            UpdateBiomes();
+        } else {
+            _changedBiomes.clear();
+        }
+    }
+
+    if (!_map.empty() && (!_shadowsValid || ExtMath::ToDegrees(angle(_sunLight, _shadowSun)) > _settings.shadowUpdateStep)) {
+        UpdateShadows();
+    }
 }
 
 void World::SetRenderedLayer(Layer layer) {
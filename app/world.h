@@ -3,15 +3,21 @@
 #include <algorithm>
 #include <cassert>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
 #include <vector>
 
 #include <library/vec2.h>
 #include <library/vec3.h>
+#include <library/vec3_batch.h>
 #include <library/ext_math.h>
 
-#include "perlin.h"
+#include "arena.h"
+#include "noise.h"
 
 #include <core/color.h>
+#include <core/packed_color.h>
 #include <core/graphics.h>
 
 using namespace REngine;
@@ -38,6 +44,14 @@ public:
             // Terrain
             Bounds<double> heightBounds{-10000, 10000};
             Bounds<double> slopeBounds{0, 90};
+            /* slopeBounds in degrees as cosines, matched against the unit normal's z.
+             * Derived from slopeBounds at config load */
+            Bounds<double> normalZBounds{0, 1};
+
+            /* standing water above the ground, 0 on dry land and positive in lakes and the sea */
+            Bounds<double> lakeDepthBounds{-10000, 10000};
+            /* matches only cells of the river mask */
+            bool river = false;
 
             Bounds<double> temperatureBounds{-278, 5000};
             Bounds<double> humidityBounds{-1000, 1000};
@@ -49,6 +63,57 @@ public:
             Color surfaceColor = Color(255, 255, 255);
         };
 
+        /* grid hydraulic erosion run after the height pass, amounts are in height units per cell */
+        struct Erosion {
+            /* simulation steps, 0 skips erosion */
+            uint32_t iterations = 0;
+            /* water added to every cell per step */
+            double rain = 0.01;
+            /* share of the water evaporating per step */
+            double evaporation = 0.05;
+            /* sediment carried per unit of outflow and of slope */
+            double capacity = 4;
+            /* share of the free capacity picked up from the ground per step */
+            double erosionRate = 0.3;
+            /* share of the excess sediment dropped per step */
+            double depositionRate = 0.3;
+        };
+
+        /* domain warp of the height field: samples move by strength times a pair of noise
+         * fields, in map widths. Bends coastlines and ridges off the lattice axes */
+        struct Warp {
+            /* 0 disables the warp */
+            double strength = 0;
+            uint32_t depth = 3;
+            uint32_t baseGridResolution = 4;
+        };
+
+        /* temperature and humidity simulation advanced by Tick, rates are per step */
+        struct Climate {
+            bool enabled = false;
+            /* game time between steps */
+            double stepMs = 50;
+            /* steps a single Tick may take, the rest of a long frame is dropped */
+            uint32_t maxStepsPerTick = 4;
+            /* share of the difference to the neighbours' mean exchanged per step, up to 1 */
+            double diffusion = 0.2;
+            /* degrees gained per step under the zenith sun, relative to the daily mean */
+            double insolation = 0.5;
+            /* share of the difference to the equilibrium temperature lost per step */
+            double cooling = 0.02;
+            /* equilibrium degrees lost per unit of height above the sea */
+            double lapseRate = 1;
+            /* share of the insolation heating water, and its cooling, water buffers heat */
+            double waterHeating = 0.2;
+            double waterCooling = 0.1;
+            /* air displacement per step in cells, carries humidity */
+            Vec2d wind = Vec2d(0.3, 0.1);
+            /* share of the missing humidity evaporating from water per step */
+            double evaporation = 0.005;
+            /* share of the difference to the generated humidity lost per step */
+            double humidityRelaxation = 0.02;
+        };
+
         struct LightSource {
             std::string name = "Sol";
             double brightness = 1;
@@ -56,44 +121,184 @@ public:
             double phase = 0;
         };
     
+        /* seed of the random generators, 0 seeds with the time */
+        uint64_t seed = 0;
         double dayDuration = 4000;
         Vec2u worldSize = Vec2u{100, 100};
+        /* GenerateProgressive starts at worldSize / previewScale, every Refine is 4 times
+         * finer up to worldSize. 1 generates the full map at once */
+        uint32_t previewScale = 1;
+        /* frame time the app spends on refining passes */
+        double generationBudgetMs = 8;
         double islandSize = 1.5;
+        /* use the ExtMath::Fast* approximations in generation and shading */
+        bool fastMath = false;
+        /* degrees the sun may move before terrain shadows are recomputed */
+        double shadowUpdateStep = 1;
+        /* cells searched for occluders of the sky, 0 disables ambient occlusion */
+        uint32_t occlusionRadius = 32;
+        Erosion erosion;
+        /* share of the map draining through a land cell that makes it a river */
+        double riverFlow = 0.001;
+        Climate climate;
 
-        PerlinNoise::Settings heightNoiseSettings;
-        PerlinNoise::Settings temperatureNoiseSettings;
-        PerlinNoise::Settings humidityNoiseSettings;
+        Noise::Settings heightNoiseSettings;
+        Warp heightWarp;
+        Noise::Settings temperatureNoiseSettings;
+        Noise::Settings humidityNoiseSettings;
 
         std::vector<LightSource> lightSources;
         std::vector<Biome> biomes;
     };
 
+    struct StageTiming {
+        const char* name;
+        double ms;
+    };
+
 public:
     World();
 
     void Generate(const Settings& settings);
+    /* generates the full map of the settings of the last Generate again */
     void Regenerate();
+    /* generates a preview at 1 / previewScale of the resolution, Refine builds the rest */
+    void GenerateProgressive(const Settings& settings);
+    /* advances the next finer pass of GenerateProgressive by about budgetMs, true if the pass
+     * was completed. The last finished pass is rendered and ticked meanwhile. False once the
+     * map is complete */
+    bool Refine(double budgetMs = std::numeric_limits<double>::infinity());
+    /* whether the full map is generated, no pass is pending */
+    bool Complete() const;
     void Render(Graphics* gr, Vec2u windowSize);
     void Tick(double dtime);
+    /* advances the climate by one step, Tick calls it every climate.stepMs */
+    void StepClimate();
+    /* reclassifies the cells whose temperature or humidity crossed a biome bound since
+     * they were last classified, Tick calls it after stepping the climate */
+    void UpdateBiomes();
+    /* row-major indices of the cells whose biome changed in the last UpdateBiomes, increasing.
+     * A Tick that does not step the climate clears it */
+    const std::vector<uint32_t>& ChangedBiomes() const;
 
     void SetRenderedLayer(Layer layer);
 
+    /* wall time of every stage of the last generation pass */
+    const std::vector<StageTiming>& GenerationTimings() const;
+
+    /* heights of the generated map, erosion included */
+    double Height(uint32_t x, uint32_t y) const;
+    /* unit surface normals of the generated map */
+    Vec3d Normal(uint32_t x, uint32_t y) const;
+
 private:
-    double GetHeight(uint32_t x, uint32_t y) {
-        return _map[y][x].height;
-    }
+    // One pass generates the whole map at 1 / scale of the resolution. Passes after the
+    // first of a generation keep its noise lattices, so refinements sample the same fields.
+    // A pass runs the STAGES in order, AdvancePass does slices of their units until the
+    // budget is spent and returns true when the pass is complete
+    void GeneratePass(uint32_t scale, bool keepNoise);
+    void StartPass(uint32_t scale, bool keepNoise);
+    bool AdvancePass(double budgetMs);
+    Settings PassSettings(uint32_t scale) const;
+    /* both warp noises, octaves of _settings.heightWarp on the lattice of the height noise */
+    Noise::Settings WarpNoiseSettings() const;
+
+    struct Stage {
+        const char* name;
+        /* prepares the stage for the current pass, returns its units of work */
+        uint64_t (World::*begin)();
+        /* does the units [first, last), called with consecutive ranges */
+        void (World::*run)(uint64_t first, uint64_t last);
+    };
+    static const Stage STAGES[];
 
-    Vec3d GetNormal(uint32_t x, uint32_t y) {
-        Vec3d p(x, y, GetHeight(x, y));
-        Vec3d p10(x + 1, y, GetHeight(x + 1, y));
-        Vec3d p01(x, y + 1, GetHeight(x, y + 1));
-        return cross_prod(p10 - p, p01 - p).normalized();
+    struct PassProgress {
+        bool active = false;
+        size_t stage = 0;
+        bool begun = false;
+        uint64_t unit = 0;
+        uint64_t units = 0;
+        // time the units done so far took and per unit of the last slice, pace the slices
+        double runMs = 0;
+        double lastPace = 0;
+    };
+
+    // generation stages, units are rows unless noted
+    /* begin of stages with nothing to prepare */
+    uint64_t Rows();
+    uint64_t Cells();
+    /* a unit per noise field */
+    uint64_t BeginNoise();
+    void GenerateNoise(uint64_t first, uint64_t last);
+    uint64_t BeginWarp();
+    void WarpHeightSamples(uint64_t first, uint64_t last);
+    uint64_t BeginFields();
+    void GenerateFields(uint64_t first, uint64_t last);
+    /* the rows copied from the map, of both passes of every step, then of the write back */
+    uint64_t BeginErosion();
+    void ErodeHeights(uint64_t first, uint64_t last);
+    /* levels of the rows, the sea and the map edges seed the flood */
+    uint64_t BeginFlood();
+    void SeedFlood(uint64_t first, uint64_t last);
+    /* a unit per flooded cell */
+    void FloodDepressions(uint64_t first, uint64_t last);
+    void FindReceivers(uint64_t first, uint64_t last);
+    /* a unit per cell in reverse flood order */
+    uint64_t BeginAccumulation();
+    void AccumulateFlow(uint64_t first, uint64_t last);
+    void MarkRivers(uint64_t first, uint64_t last);
+    uint64_t BeginNormals();
+    void ComputeNormals(uint64_t first, uint64_t last);
+    /* the rows of every level of the height pyramid */
+    uint64_t BeginOcclusion();
+    void BuildHeightMips(uint64_t first, uint64_t last);
+    void ComputeOcclusion(uint64_t first, uint64_t last);
+    uint64_t BeginBiomes();
+    void ClassifyBiomes(uint64_t first, uint64_t last);
+    uint64_t BeginClimate();
+    void InitClimate(uint64_t first, uint64_t last);
+
+    /* shades the current layer of the map into _pixels */
+    void ShadeMap();
+
+    /* index of the first biome matching the cell's fields */
+    uint32_t ClassifyCell(double height, double normalZ, double lakeDepth, bool river, double temperature, double humidity) const;
+    /* temperature and humidity ranks among the biome bounds, a byte each */
+    uint16_t ClimateRank(float temperature, float humidity) const;
+    /* ranks go up to twice the number of thresholds, 254 still fits a byte */
+    static constexpr size_t MAX_RANKED_THRESHOLDS = 127;
+    /* values of rank r lie in (lower, upper), or equal upper when equal is set */
+    struct RankBracket {
+        double lower;
+        double upper;
+        bool equal;
+    };
+    static void BuildRankBrackets(const Arena::Plane<double>& thresholds, Arena::Plane<RankBracket>& brackets);
+
+    /* rebuilds _sunVisibility for the current sun, and _horizon if the azimuth moved */
+    void UpdateShadows();
+    /* horizon elevation of every cell looking towards azimuth (radians, counterclockwise from +x) */
+    void ComputeHorizon(double azimuth);
+
+    double GetHeight(uint32_t x, uint32_t y) {
+        return MapCell(x, y).height;
     }
 
     Layer _renderedLayer = Layer::SURFACE;
 
     double _time = 0;
+    /* settings of the current pass, _fullSettings scaled down by _passScale */
     Settings _settings;
+    /* derived with _settings, noises generated from kept settings do not allocate */
+    Noise::Settings _warpNoiseSettings;
+    Settings _fullSettings;
+    uint32_t _passScale = 1;
+    /* _settings are not those of _passScale for _fullSettings */
+    bool _passSettingsStale = true;
+    PassProgress _pass;
+    /* full resolution cells along the side of a cell of the current pass, distances in
+     * normals and shading are in full resolution cells */
+    double _cellSpan = 1;
 
     double _dayDuration = 5000;
 
@@ -107,19 +312,144 @@ private:
     Vec2u _size;
 
     struct Cell {
-        double height;
-        double temperature;
-        double humidity;
-        Vec3d normal;
+        Real height;
         uint32_t biome;
     };
 
-    std::vector<std::vector<Cell>> _map;
+    Cell& MapCell(uint32_t x, uint32_t y) {
+        return _map[static_cast<size_t>(y) * (_settings.worldSize.x + 1) + x];
+    }
+
+    /* row-major with a spare column and row past the east and south edges */
+    Arena::Plane<Cell> _map;
+    /* climate fields, row-major like _normals, stepped by StepClimate */
+    Arena::Plane<float> _temperature;
+    Arena::Plane<float> _humidity;
+
+    // Per-cell StepClimate coefficients set by InitClimate, and the next step's fields.
+    // normal holds _normals in float, equilibrium is the temperature cooling tends to
+    struct ClimateBuffers {
+        Arena::Plane<float> normal[3];
+        Arena::Plane<float> heating;
+        Arena::Plane<float> cooling;
+        Arena::Plane<float> equilibrium;
+        Arena::Plane<float> evaporation;
+        Arena::Plane<float> baseHumidity;
+        Arena::Plane<float> nextTemperature;
+        Arena::Plane<float> nextHumidity;
+    };
+    ClimateBuffers _climate;
+    double _climateTime = 0;
+
+    // Biome bounds on temperature and humidity, sorted and unique, set by InitClimate.
+    // A cell is reclassified only when the ranks of its fields among them change
+    Arena::Plane<double> _temperatureThresholds;
+    Arena::Plane<double> _humidityThresholds;
+    Arena::Plane<RankBracket> _temperatureBrackets;
+    Arena::Plane<RankBracket> _humidityBrackets;
+    Arena::Plane<uint16_t> _climateRanks;
+    /* too many thresholds for a rank byte, UpdateBiomes reclassifies every cell instead */
+    bool _reclassifyAll = false;
+    std::vector<uint32_t> _changedBiomes;
+    /* per band parts of _changedBiomes */
+    std::vector<std::vector<uint32_t>> _changedBands;
+
+    // Noise sample coordinates of every cell, WarpHeightSamples leaves the warped height
+    // samples in them. Batches write to sampleValues, and the y warp to sampleOffsets,
+    // which is empty without a warp
+    Arena::Plane<Real> _sampleX;
+    Arena::Plane<Real> _sampleY;
+    Arena::Plane<Real> _sampleValues;
+    Arena::Plane<Real> _sampleOffsets;
+
+    // ErodeHeights state, row-major worldSize.x * worldSize.y. flux holds the water leaving
+    // each cell towards -x, +x, -y and +y, concentration is the sediment per unit of water
+    struct ErosionBuffers {
+        Arena::Plane<float> height;
+        Arena::Plane<float> water;
+        Arena::Plane<float> sediment;
+        Arena::Plane<float> concentration;
+        Arena::Plane<float> slope;
+        Arena::Plane<float> flux[4];
+    };
+    ErosionBuffers _erosion;
+
+    // Drainage, row-major like _normals. _waterLevel is the height with depressions filled
+    // up to their spill point (0 over the sea), every cell drains into _receivers[i] (itself
+    // at outlets), _flow counts the cells draining through it, itself included
+    Arena::Plane<float> _waterLevel;
+    Arena::Plane<uint32_t> _receivers;
+    Arena::Plane<float> _flow;
+    Arena::Plane<uint8_t> _rivers;
+    /* flood visiting order, every receiver comes before its donors */
+    Arena::Plane<uint32_t> _drainageOrder;
+    // Priority flood between slices: closed cells, the heap of cells above the current
+    // level and the FIFO of cells at or below it, read from levelHead
+    struct FloodState {
+        using Entry = std::pair<float, uint32_t>;
+        /* min-heap of (height, cell), clear keeps the storage */
+        struct OpenHeap : std::priority_queue<Entry, Arena::Plane<Entry>, std::greater<Entry>> {
+            void clear() {
+                c.clear();
+            }
+            void reserve(size_t n) {
+                c.reserve(n);
+            }
+        };
+        Arena::Plane<uint8_t> closed;
+        OpenHeap open;
+        Arena::Plane<uint32_t> level;
+        size_t levelHead = 0;
+    };
+    FloodState _flood;
+
+    /* surface normals, row-major worldSize.x * worldSize.y */
+    Vec3Batch<Real, Arena::Allocator<Real>> _normals;
+
+    // Sun shadows, row-major like _normals. _horizon is the elevation (radians) of the
+    // terrain horizon towards _horizonAzimuth, _sunVisibility is 0 (shadowed) to 255 (lit)
+    // for _shadowSun. Tick rebuilds them when the sun moves by more than shadowUpdateStep
+    std::vector<float> _horizon;
+    /* upper hulls of the lines of ComputeHorizon */
+    std::vector<std::vector<Vec2d>> _horizonHulls;
+    double _horizonAzimuth = 0;
+    bool _horizonValid = false;
+    std::vector<uint8_t> _sunVisibility;
+    Vec3d _shadowSun;
+    bool _shadowsValid = false;
+
+    /* sky visibility, 0 (fully occluded) to 255 (open sky), scales the ambient light */
+    Arena::Plane<uint8_t> _skyVisibility;
+    // Max-height pyramid of ComputeOcclusion, level k covers 2^k x 2^k cells. The levels in
+    // use are the first _heightMipSizes.size(), finer maps leave the ones past them allocated
+    Arena::Plane<Arena::Plane<float>> _heightMips;
+    Arena::Plane<Vec2u> _heightMipSizes;
+    /* cell offset, inverse distance and pyramid level of every occluder sample, per direction */
+    struct OcclusionSample {
+        int32_t dx;
+        int32_t dy;
+        float inverseDistance;
+        uint32_t level;
+    };
+    static constexpr int OCCLUSION_DIRECTIONS = 8;
+    Arena::Plane<OcclusionSample> _occlusionSamples[OCCLUSION_DIRECTIONS];
+
+    // Render output and per-row scratch, reused across frames
+    std::vector<PackedColor> _pixels;
+    /* a pass finished after the last ShadeMap */
+    bool _pixelsStale = false;
+    Vec2u _pixelsSize;
+    std::vector<PackedColor> _rowColors;
+    std::vector<float> _rowPlanes[3];
+    std::vector<Real> _rowSun;
+    std::vector<Real> _rowMoon;
 
-    PerlinNoise _heightNoise;
-    PerlinNoise _temperatureNoise;
-    PerlinNoise _humidityNoise;
+    std::unique_ptr<Noise> _heightNoise;
+    /* offsets of the height samples along x and y, null without a warp */
+    std::unique_ptr<Noise> _warpNoise[2];
+    std::unique_ptr<Noise> _temperatureNoise;
+    std::unique_ptr<Noise> _humidityNoise;
 
 
-    sf::Texture _tex;
+    std::vector<StageTiming> _generationTimings;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+struct Options {
+    /* world sides to run the size-dependent benchmarks at */
+    std::vector<uint32_t> sizes;
+    std::string configPath;
+    /* each benchmark repeats until this much time is spent, but runs at least once */
+    double minTimeMs;
+    /* run only benchmarks whose name contains this */
+    std::string filter;
+};
+
+struct Result {
+    std::string name;
+    /* side of the square of processed cells */
+    uint32_t size;
+    /* work items per iteration */
+    uint64_t cells;
+    uint32_t iterations;
+    /* fastest iteration */
+    double bestMs;
+    /* largest difference from a reference path, for accuracy results that time nothing */
+    double maxDeviation = -1;
+    /* heap allocations of all iterations, only the generation arena's without
+     * RENGINE_TRACK_ALLOCATIONS, for the results that count them */
+    int64_t allocations = -1;
+
+    double NsPerCell() const;
+    double CellsPerSecond() const;
+};
+
+using Results = std::vector<Result>;
+
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool Enabled(const Options& options, const std::string& name);
+
+/* prints a human readable line to stderr and keeps the result for the report,
+ * results with a maxDeviation report it instead of the timings */
+void Report(Results& results, Result result);
+
+/* times fn until options.minTimeMs is spent, keeps the best iteration */
+template <typename Fn>
+void Measure(const Options& options, Results& results, const std::string& name, uint32_t size, uint64_t cells, Fn&& fn) {
+    if (!Enabled(options, name)) {
+        return;
+    }
+    Result result{name, size, cells, 0, 1e300};
+    double total = 0;
+    while (result.iterations == 0 || total < options.minTimeMs) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = ElapsedMs(start);
+        total += ms;
+        result.bestMs = std::min(result.bestMs, ms);
+        ++result.iterations;
+    }
+    Report(results, result);
+}
+
+void RunMathBenchmarks(const Options& options, Results& results);
+void RunNoiseBenchmarks(const Options& options, Results& results);
+void RunSpriteBenchmarks(const Options& options, Results& results);
+void RunWorldBenchmarks(const Options& options, Results& results);
+
+} // namespace Bench
@@ -0,0 +1,183 @@
+#include "bench.h"
+
+#include <core/color.h>
+#include <core/packed_color.h>
+#include <library/fast_math.h>
+#include <library/vec2.h>
+#include <library/vec3.h>
+#include <library/vec3_batch.h>
+
+using namespace REngine;
+
+namespace Bench {
+
+namespace {
+
+// element-wise kernels do not depend on the world size, run them once on SIDE^2 elements
+constexpr uint32_t SIDE = 1024;
+constexpr uint32_t COUNT = SIDE * SIDE;
+
+} // namespace
+
+void RunMathBenchmarks(const Options& options, Results& results) {
+    std::vector<Color> colors(COUNT, Color(120, 200, 40));
+    std::vector<float> factors(COUNT);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        factors[i] = (i % 97) / 64.f;
+    }
+
+    Measure(options, results, "color/scale", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            Color c = colors[i] * factors[i];
+            DoNotOptimize(c);
+        }
+    });
+
+    Measure(options, results, "color/scale_scale", SIDE, COUNT, [&] {
+        // same shape as the surface shading, color * light * albedo
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            Color c = colors[i] * factors[i] * 0.9f;
+            DoNotOptimize(c);
+        }
+    });
+
+    Measure(options, results, "color/add", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i + 1 < COUNT; ++i) {
+            Color c = colors[i] + colors[i + 1];
+            DoNotOptimize(c);
+        }
+    });
+
+    std::vector<PackedColor> packed(COUNT, PackedColor(120, 200, 40));
+    std::vector<PackedColor> packedOut(COUNT);
+
+    Measure(options, results, "packed_color/scale", SIDE, COUNT, [&] {
+        ScaleColors(packed.data(), factors.data(), packedOut.data(), COUNT);
+        DoNotOptimize(packedOut[COUNT - 1]);
+    });
+
+    Measure(options, results, "packed_color/add", SIDE, COUNT, [&] {
+        AddColors(packed.data(), packedOut.data(), packedOut.data(), COUNT);
+        DoNotOptimize(packedOut[COUNT - 1]);
+    });
+
+    Measure(options, results, "packed_color/lerp", SIDE, COUNT, [&] {
+        LerpColors(packed.data(), packedOut.data(), factors.data(), packedOut.data(), COUNT);
+        DoNotOptimize(packedOut[COUNT - 1]);
+    });
+
+    Measure(options, results, "packed_color/pack", SIDE, COUNT, [&] {
+        PackColors(factors.data(), factors.data(), factors.data(), packedOut.data(), COUNT);
+        DoNotOptimize(packedOut[COUNT - 1]);
+    });
+
+    std::vector<Vec2d> v2(COUNT);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        v2[i] = Vec2d(i % SIDE, i / SIDE);
+    }
+
+    Measure(options, results, "vec2d/scale_add", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i + 1 < COUNT; ++i) {
+            Vec2d v = v2[i] * 0.5 + v2[i + 1];
+            DoNotOptimize(v);
+        }
+    });
+
+    Measure(options, results, "vec2d/normalized", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            Vec2d v = v2[i].normalized();
+            DoNotOptimize(v);
+        }
+    });
+
+    std::vector<Vec3d> v3(COUNT);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        v3[i] = Vec3d(i % SIDE, i / SIDE, factors[i]);
+    }
+
+    Measure(options, results, "vec3d/dot", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i + 1 < COUNT; ++i) {
+            double d = dot_prod(v3[i], v3[i + 1]);
+            DoNotOptimize(d);
+        }
+    });
+
+    Measure(options, results, "vec3d/cross", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i + 1 < COUNT; ++i) {
+            Vec3d v = cross_prod(v3[i], v3[i + 1]);
+            DoNotOptimize(v);
+        }
+    });
+
+    Measure(options, results, "vec3d/normalized", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            Vec3d v = v3[i].normalized();
+            DoNotOptimize(v);
+        }
+    });
+
+    Vec3Batch<double> batch;
+    batch.resize(COUNT);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        batch.set(i, v3[i]);
+    }
+    Vec3Batch<double> batchOut;
+    batchOut.resize(COUNT);
+    std::vector<double> scalars(COUNT);
+
+    Measure(options, results, "vec3_batch/dot", SIDE, COUNT, [&] {
+        dot_prod(batch.span(0, COUNT - 1), batch.span(1, COUNT - 1), scalars.data());
+        DoNotOptimize(scalars[0]);
+    });
+
+    Measure(options, results, "vec3_batch/cross", SIDE, COUNT, [&] {
+        cross_prod(batch.span(0, COUNT - 1), batch.span(1, COUNT - 1), batchOut.span(0, COUNT - 1));
+        DoNotOptimize(batchOut.x[0]);
+    });
+
+    batchOut = batch;
+    Measure(options, results, "vec3_batch/normalize", SIDE, COUNT, [&] {
+        // already unit after the first iteration, the cost does not depend on the values
+        normalize(batchOut.span());
+        DoNotOptimize(batchOut.x[0]);
+    });
+
+    Measure(options, results, "vec3_batch/lerp", SIDE, COUNT, [&] {
+        lerp(batch.span(0, COUNT - 1), batch.span(1, COUNT - 1), 0.25, batchOut.span(0, COUNT - 1));
+        DoNotOptimize(batchOut.x[0]);
+    });
+
+    // std and fast versions over the same inputs, results summed so the loops are not dropped
+    std::vector<double> args(COUNT);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        args[i] = (i % 2001) / 1000. - 1;
+    }
+    auto sum = [&](auto&& fn) {
+        double s = 0;
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            s += fn(args[i]);
+        }
+        DoNotOptimize(s);
+    };
+
+    Measure(options, results, "math/std_exp", SIDE, COUNT, [&] { sum([](double x) { return std::exp(x); }); });
+    Measure(options, results, "math/fast_exp", SIDE, COUNT, [&] { sum([](double x) { return ExtMath::FastExp(x); }); });
+    Measure(options, results, "math/std_pow4", SIDE, COUNT, [&] { sum([](double x) { return std::pow(x, 4); }); });
+    Measure(options, results, "math/pow_int4", SIDE, COUNT, [&] { sum([](double x) { return ExtMath::PowInt(x, 4); }); });
+    Measure(options, results, "math/std_acos", SIDE, COUNT, [&] { sum([](double x) { return std::acos(x); }); });
+    Measure(options, results, "math/fast_acos", SIDE, COUNT, [&] { sum([](double x) { return ExtMath::FastAcos(x); }); });
+    Measure(options, results, "math/std_atan2", SIDE, COUNT, [&] { sum([](double x) { return std::atan2(x, 0.5); }); });
+    Measure(options, results, "math/fast_atan2", SIDE, COUNT, [&] { sum([](double x) { return ExtMath::FastAtan2(x, 0.5); }); });
+    Measure(options, results, "math/std_sincos", SIDE, COUNT, [&] {
+        sum([](double x) { return std::sin(x * 5) + std::cos(x * 5); });
+    });
+    Measure(options, results, "math/fast_sincos", SIDE, COUNT, [&] {
+        sum([](double x) {
+            double s, c;
+            ExtMath::FastSinCos(x * 5, s, c);
+            return s + c;
+        });
+    });
+}
+
+} // namespace Bench
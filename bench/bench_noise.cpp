@@ -0,0 +1,99 @@
+#include "bench.h"
+
+#include "parse_config.h"
+#include "noise.h"
+#include "perlin.h"
+
+namespace Bench {
+
+void RunNoiseBenchmarks(const Options& options, Results& results) {
+    Config config = ParseConfigFromFile(options.configPath);
+
+    // both engines at the octave count and resolution of the height field
+    const std::pair<const char*, Noise::Engine> engines[] = {
+        {"perlin", Noise::Engine::PERLIN},
+        {"simplex", Noise::Engine::SIMPLEX},
+    };
+    for (const auto& [engineName, engine] : engines) {
+        auto noise = Noise::Create(engine);
+        noise->Generate(config.heightNoiseSettings);
+        const std::string prefix = engineName;
+
+        for (uint32_t size : options.sizes) {
+            uint64_t cells = uint64_t(size) * size;
+
+            Measure(options, results, prefix + "/single", size, cells, [&] {
+                for (uint32_t y = 0; y < size; ++y) {
+                    for (uint32_t x = 0; x < size; ++x) {
+                        double v = (*noise)(Vec2d(double(x) / size, double(y) / size));
+                        DoNotOptimize(v);
+                    }
+                }
+            });
+
+            // one world row per batch, the way the generation passes walk the map
+            std::vector<Real> xs(size);
+            std::vector<Real> ys(size);
+            std::vector<Real> out(size);
+            for (uint32_t x = 0; x < size; ++x) {
+                xs[x] = Real(x) / size;
+            }
+            Measure(options, results, prefix + "/batch_row", size, cells, [&] {
+                for (uint32_t y = 0; y < size; ++y) {
+                    std::fill(ys.begin(), ys.end(), Real(y) / size);
+                    noise->Sample(xs.data(), ys.data(), out.data(), size);
+                    DoNotOptimize(out.data());
+                }
+            });
+        }
+    }
+
+    // Perlin in float and in double from the same seed, so the same gradients up to rounding.
+    // Both read and write the build's Real, the deviation is the largest difference of the
+    // height field values, transformer included
+    auto generate = [&](Noise& noise) {
+        ExtMath::SeedRandom(1);
+        noise.Generate(config.heightNoiseSettings);
+    };
+    BasicPerlinNoise<float> single;
+    BasicPerlinNoise<double> reference;
+    generate(single);
+    generate(reference);
+    for (uint32_t size : options.sizes) {
+        uint64_t cells = uint64_t(size) * size;
+        std::vector<Real> xs(size);
+        std::vector<Real> ys(size);
+        std::vector<Real> out(size);
+        std::vector<Real> referenceOut(size);
+        for (uint32_t x = 0; x < size; ++x) {
+            xs[x] = Real(x) / size;
+        }
+        auto sampleRows = [&](Noise& noise) {
+            for (uint32_t y = 0; y < size; ++y) {
+                std::fill(ys.begin(), ys.end(), Real(y) / size);
+                noise.Sample(xs.data(), ys.data(), out.data(), size);
+                DoNotOptimize(out.data());
+            }
+        };
+        Measure(options, results, "perlin/float/batch_row", size, cells, [&] { sampleRows(single); });
+        Measure(options, results, "perlin/double/batch_row", size, cells, [&] { sampleRows(reference); });
+
+        const std::string deviationName = "perlin/float/max_deviation";
+        if (Enabled(options, deviationName)) {
+            double deviation = 0;
+            for (uint32_t y = 0; y < size; ++y) {
+                std::fill(ys.begin(), ys.end(), Real(y) / size);
+                single.Sample(xs.data(), ys.data(), out.data(), size);
+                reference.Sample(xs.data(), ys.data(), referenceOut.data(), size);
+                for (uint32_t x = 0; x < size; ++x) {
+                    deviation = std::max(deviation, std::abs(double(out[x]) - referenceOut[x]));
+                }
+            }
+            Result result{deviationName, size, cells, 0, 0};
+            result.maxDeviation = deviation;
+            Report(results, result);
+        }
+    }
+}
+
+} // namespace Bench
@@ -0,0 +1,117 @@
+#include "bench.h"
+
+#include <core/headless_graphics.h>
+#include <core/sprite_batch.h>
+#include <core/texture_atlas.h>
+
+#include <cstdlib>
+
+using namespace REngine;
+
+namespace Bench {
+
+namespace {
+
+const Vec2i SCREEN_SIZE{800, 800};
+
+// icons of 8..39 pixels, drawn on a SIDE^2 grid over the screen
+constexpr uint32_t ICONS = 64;
+constexpr uint32_t SIDE = 64;
+constexpr uint32_t COUNT = SIDE * SIDE;
+
+struct Icon {
+    Vec2<uint32_t> size;
+    std::vector<PackedColor> pixels;
+};
+
+std::vector<Icon> MakeIcons() {
+    std::vector<Icon> icons(ICONS);
+    for (uint32_t i = 0; i < ICONS; ++i) {
+        Icon& icon = icons[i];
+        icon.size = Vec2<uint32_t>(8 + i % 32, 8 + (i * 7) % 32);
+        icon.pixels.resize(icon.size.x * icon.size.y);
+        for (uint32_t y = 0; y < icon.size.y; ++y) {
+            for (uint32_t x = 0; x < icon.size.x; ++x) {
+                // a disc with a transparent outside, so that blending is exercised too
+                int dx = 2 * x + 1 - icon.size.x;
+                int dy = 2 * y + 1 - icon.size.y;
+                bool inside = dx * dx + dy * dy <= int(icon.size.x * icon.size.x);
+                icon.pixels[y * icon.size.x + x] = PackedColor(i * 4, x * 8, y * 8, inside ? 255 : 0);
+            }
+        }
+    }
+    return icons;
+}
+
+Vec2<float> SpritePosition(uint32_t i) {
+    float step = float(SCREEN_SIZE.x) / SIDE;
+    return Vec2<float>((i % SIDE + 0.5f) * step, (i / SIDE + 0.5f) * step);
+}
+
+} // namespace
+
+void RunSpriteBenchmarks(const Options& options, Results& results) {
+    const std::vector<Icon> icons = MakeIcons();
+
+    Measure(options, results, "sprites/pack", ICONS, ICONS, [&] {
+        TextureAtlas atlas(256);
+        for (const Icon& icon : icons) {
+            DoNotOptimize(atlas.Add(icon.pixels.data(), icon.size));
+        }
+    });
+
+    TextureAtlas atlas(256);
+    std::vector<TextureAtlas::Region> regions;
+    for (const Icon& icon : icons) {
+        regions.push_back(*atlas.Add(icon.pixels.data(), icon.size));
+    }
+    const Vec2<float> size(16, 16);
+
+    // one draw call per sprite, the way DrawTexture draws, against one per atlas page
+    HeadlessGraphics single(SCREEN_SIZE);
+    Measure(options, results, "sprites/draw_image", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            const Icon& icon = icons[i % ICONS];
+            single.DrawImage(icon.pixels.data(), icon.size, SpritePosition(i), size);
+        }
+        single.Present();
+    });
+
+    HeadlessGraphics batched(SCREEN_SIZE);
+    SpriteBatch batch(atlas);
+    Measure(options, results, "sprites/batch", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            batch.Draw(regions[i % ICONS], SpritePosition(i), size);
+        }
+        batch.Flush(batched);
+        batched.Present();
+    });
+    Measure(options, results, "sprites/batch_rotated", SIDE, COUNT, [&] {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            batch.Draw(regions[i % ICONS], SpritePosition(i), size, i * 0.1f);
+        }
+        batch.Flush(batched);
+        batched.Present();
+    });
+
+    // the batch samples the atlas as DrawImage samples the icon, both frames should match
+    if (Enabled(options, "sprites/batch/max_deviation")) {
+        single.Clear();
+        batched.Clear();
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            const Icon& icon = icons[i % ICONS];
+            single.DrawImage(icon.pixels.data(), icon.size, SpritePosition(i), size);
+            batch.Draw(regions[i % ICONS], SpritePosition(i), size);
+        }
+        batch.Flush(batched);
+        int deviation = 0;
+        for (size_t i = 0; i < 4ull * SCREEN_SIZE.x * SCREEN_SIZE.y; ++i) {
+            deviation = std::max(deviation, std::abs(single.Pixels()[i] - batched.Pixels()[i]));
+        }
+        Result result{"sprites/batch/max_deviation", SIDE, COUNT, 1, 0};
+        result.maxDeviation = deviation;
+        Report(results, result);
+    }
+}
+
+} // namespace Bench
@@ -0,0 +1,134 @@
+#include "bench.h"
+
+#include "arena.h"
+#include "parse_config.h"
+#include "world.h"
+
+#include <core/headless_graphics.h>
+#include <library/alloc_tracker.h>
+
+#include <map>
+
+using namespace REngine;
+
+namespace Bench {
+
+namespace {
+
+const Vec2i SCREEN_SIZE{800, 800};
+
+} // namespace
+
+void RunWorldBenchmarks(const Options& options, Results& results) {
+    // all names start with "world/", the map is generated even if only rendering is measured
+    if (!options.filter.empty() && options.filter.find("world") == std::string::npos) {
+        return;
+    }
+    Config config = ParseConfigFromFile(options.configPath);
+    auto graphics = std::make_shared<HeadlessGraphics>(SCREEN_SIZE);
+
+    for (uint32_t size : options.sizes) {
+        uint64_t cells = uint64_t(size) * size;
+        config.worldSize = Vec2u(size, size);
+
+        // the climate is stepped only by its own benchmark, not by the Ticks of the others
+        config.climate.enabled = true;
+        config.climate.maxStepsPerTick = 0;
+        World world;
+        world.Generate(config);
+        world.Render(graphics.get(), SCREEN_SIZE);
+
+        // every stage is timed inside one Regenerate, keep the best run of each. Generate
+        // sized the buffers already and Render the shading, regenerations of the same size
+        // should not allocate. Builds with RENGINE_TRACK_ALLOCATIONS count every heap
+        // allocation, others those of the arena. Only Regenerate is counted, not the bookkeeping
+        auto countAllocations = [] {
+            return AllocTracker::Enabled() ? AllocTracker::Totals().allocations : Arena::Allocations();
+        };
+        Result total{"world/regenerate", size, cells, 0, 1e300};
+        std::map<std::string, Result> stages;
+        double spent = 0;
+        total.allocations = 0;
+        while (total.iterations == 0 || spent < options.minTimeMs) {
+            const uint64_t allocations = countAllocations();
+            auto start = std::chrono::steady_clock::now();
+            world.Regenerate();
+            double ms = ElapsedMs(start);
+            total.allocations += countAllocations() - allocations;
+            spent += ms;
+            total.bestMs = std::min(total.bestMs, ms);
+            ++total.iterations;
+
+            for (const auto& timing : world.GenerationTimings()) {
+                std::string name = std::string("world/stage/") + timing.name;
+                auto [it, inserted] = stages.try_emplace(name, Result{name, size, cells, 0, timing.ms});
+                it->second.bestMs = std::min(it->second.bestMs, timing.ms);
+                ++it->second.iterations;
+            }
+        }
+        if (Enabled(options, total.name)) {
+            Report(results, total);
+        }
+        for (auto& [name, stage] : stages) {
+            if (Enabled(options, name)) {
+                Report(results, stage);
+            }
+        }
+
+        Measure(options, results, "world/climate/step", size, cells, [&] {
+            world.StepClimate();
+        });
+        Measure(options, results, "world/climate/step_reclassify", size, cells, [&] {
+            world.StepClimate();
+            world.UpdateBiomes();
+        });
+
+        // mid-afternoon, the sun is up and mountains cast shadows
+        const double day = config.dayDuration;
+        world.Tick(day * 3 / 8);
+        const std::pair<const char*, World::Layer> layers[] = {
+            {"world/render/surface", World::Layer::SURFACE},
+            {"world/render/temperature", World::Layer::TEMPERATURE},
+            {"world/render/humidity", World::Layer::HUMIDITY},
+        };
+        for (const auto& [name, layer] : layers) {
+            world.SetRenderedLayer(layer);
+            Measure(options, results, name, size, cells, [&] {
+                world.Render(graphics.get(), SCREEN_SIZE);
+                graphics->Present();
+            });
+        }
+
+        // every tick moves the sun past shadowUpdateStep, back and forth around the same time of day
+        const double sunStep = day * config.shadowUpdateStep * 2 / 360;
+        bool forward = true;
+        Measure(options, results, "world/shadows/visibility", size, cells, [&] {
+            world.Tick(forward ? sunStep : day - sunStep);
+            forward = !forward;
+        });
+
+        // crossing noon flips the azimuth, so the horizon sweep reruns too
+        const double offNoon = day * 10 / 360;
+        world.Tick(day / 8 - offNoon + (forward ? 0 : sunStep));
+        forward = true;
+        Measure(options, results, "world/shadows/horizon", size, cells, [&] {
+            world.Tick(forward ? 2 * offNoon : day - 2 * offNoon);
+            forward = !forward;
+        });
+
+        // the first pass of a progressive generation is what shows up right away,
+        // then the whole generation up to the full map
+        Config progressive = config;
+        progressive.previewScale = 16;
+        Measure(options, results, "world/progressive/preview", size, cells, [&] {
+            world.GenerateProgressive(progressive);
+        });
+        Measure(options, results, "world/progressive/complete", size, cells, [&] {
+            world.GenerateProgressive(progressive);
+            while (world.Refine()) {
+            }
+        });
+    }
+}
+
+} // namespace Bench
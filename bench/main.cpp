@@ -0,0 +1,132 @@
+#include "bench.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Bench [--sizes 256,512,...] [--max-size N] [--min-time MS] [--filter SUBSTR]
+//       [--config world_settings.json] [--out bench_results.json]
+//
+// Results go to --out as JSON, a readable table goes to stderr.
+
+namespace Bench {
+
+double Result::NsPerCell() const {
+    return bestMs * 1e6 / cells;
+}
+
+double Result::CellsPerSecond() const {
+    return cells / (bestMs * 1e-3);
+}
+
+bool Enabled(const Options& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+void Report(Results& results, Result result) {
+    if (result.maxDeviation >= 0) {
+        std::fprintf(stderr, "%-40s %6u  max deviation %.3g\n", result.name.c_str(), result.size, result.maxDeviation);
+        results.push_back(std::move(result));
+        return;
+    }
+    std::fprintf(stderr, "%-40s %6u  %10.3f ms  %10.2f ns/cell  %12.4g cells/s  (%u it)",
+            result.name.c_str(), result.size, result.bestMs,
+            result.NsPerCell(), result.CellsPerSecond(), result.iterations);
+    if (result.allocations >= 0) {
+        std::fprintf(stderr, "  %lld allocations", static_cast<long long>(result.allocations));
+    }
+    std::fprintf(stderr, "\n");
+    results.push_back(std::move(result));
+}
+
+} // namespace Bench
+
+using namespace Bench;
+
+std::vector<uint32_t> ParseSizes(const std::string& list) {
+    std::vector<uint32_t> sizes;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        sizes.push_back(std::stoul(item));
+    }
+    return sizes;
+}
+
+int main(int argc, char** argv) {
+    Options options{
+        .sizes = {256, 512, 1024, 2048, 4096, 8192},
+        .configPath = "world_settings.json",
+        .minTimeMs = 200,
+        .filter = "",
+    };
+    uint32_t maxSize = 0;
+    std::string outPath = "bench_results.json";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--sizes") {
+            options.sizes = ParseSizes(value);
+        } else if (key == "--max-size") {
+            maxSize = std::stoul(value);
+        } else if (key == "--min-time") {
+            options.minTimeMs = std::stod(value);
+        } else if (key == "--filter") {
+            options.filter = value;
+        } else if (key == "--config") {
+            options.configPath = value;
+        } else if (key == "--out") {
+            outPath = value;
+        } else {
+            std::cerr << "unknown option " << key << std::endl;
+            return 1;
+        }
+    }
+    if (maxSize) {
+        auto tooLarge = [=](uint32_t s) { return s > maxSize; };
+        options.sizes.erase(std::remove_if(options.sizes.begin(), options.sizes.end(), tooLarge), options.sizes.end());
+    }
+
+    Results results;
+    RunMathBenchmarks(options, results);
+    RunNoiseBenchmarks(options, results);
+    RunSpriteBenchmarks(options, results);
+    RunWorldBenchmarks(options, results);
+
+    nlohmann::ordered_json report;
+    report["benchmarks"] = nlohmann::ordered_json::array();
+    for (const auto& r : results) {
+        if (r.maxDeviation >= 0) {
+            report["benchmarks"].push_back({
+                {"name", r.name},
+                {"size", r.size},
+                {"max_deviation", r.maxDeviation},
+            });
+            continue;
+        }
+        report["benchmarks"].push_back({
+            {"name", r.name},
+            {"size", r.size},
+            {"cells", r.cells},
+            {"iterations", r.iterations},
+            {"best_ms", r.bestMs},
+            {"ns_per_cell", r.NsPerCell()},
+            {"cells_per_s", r.CellsPerSecond()},
+        });
+        if (r.allocations >= 0) {
+            report["benchmarks"].back()["allocations"] = r.allocations;
+        }
+    }
+
+    std::ofstream out(outPath);
+    out << report.dump(2) << std::endl;
+    if (!out) {
+        std::cerr << "can not write " << outPath << std::endl;
+        return 1;
+    }
+}
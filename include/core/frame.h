@@ -2,6 +2,7 @@
 #include <memory>
 #include <string>
 
+#include <core/frame_stats.h>
 #include <core/graphics.h>
 #include <core/input.h>
 #include <library/vec2.h>
@@ -26,6 +27,8 @@ public:
 
 public:
     Frame(Settings settings, Frame* parent = nullptr, std::shared_ptr<sf::RenderWindow> window = {});
+    /* root frame without a window, e.g. over HeadlessGraphics */
+    Frame(Settings settings, Graphics::SPtr graphics);
 
     virtual void Initialize() = 0;
     virtual bool Update(float elapsedMs);
@@ -34,6 +37,12 @@ public:
 
     virtual ~Frame() = default;
 
+    /* frame timings, recorded by the driver */
+    FrameStats& Stats();
+
+    /* false while the frame still builds its content, e.g. a world being generated */
+    virtual bool IsSettled() const;
+
 protected:
     Graphics* Gr();
     InputController* Ic();
@@ -48,6 +57,7 @@ protected:
 private:
     std::shared_ptr<Graphics> _graphics;
     std::shared_ptr<InputController> _inputController;
+    FrameStats _stats;
 
     bool _isRunning;
 };
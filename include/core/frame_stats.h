@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace REngine {
+
+/* Rolling frame-time statistics over the last WINDOW frames, fed by the driver */
+class FrameStats {
+public:
+    static constexpr uint32_t WINDOW = 240;
+
+    static constexpr float BUCKET_MS = 0.25f;
+    static constexpr uint32_t BUCKETS = 400; /* last bucket also counts everything slower */
+
+public:
+    FrameStats();
+
+    /* frameMs is the full loop period, including sleeps and vsync. allocations are the heap
+     * allocations of the frame, counted when built with RENGINE_TRACK_ALLOCATIONS */
+    void Record(float frameMs, float updateMs, float renderMs, uint64_t allocations = 0);
+
+    uint32_t FrameCount() const;
+
+    float Fps() const;
+    float AverageUpdateMs() const;
+    float AverageRenderMs() const;
+    float AverageAllocations() const;
+    uint64_t LastAllocations() const;
+
+    /* upper bound of the histogram bucket containing the p-th percentile, p in [0, 1] */
+    float Percentile(float p) const;
+
+    /* frames per bucket, bucket i covers [i * BUCKET_MS, (i + 1) * BUCKET_MS) */
+    const std::array<uint32_t, BUCKETS>& Histogram() const;
+
+private:
+    static uint32_t BucketOf(float ms);
+
+    struct Sample {
+        float frameMs;
+        float updateMs;
+        float renderMs;
+        uint64_t allocations;
+    };
+
+    std::vector<Sample> _samples;
+    uint32_t _next = 0;
+    uint32_t _count = 0;
+
+    double _frameSum = 0;
+    double _updateSum = 0;
+    double _renderSum = 0;
+    uint64_t _allocationSum = 0;
+
+    std::array<uint32_t, BUCKETS> _histogram;
+};
+
+} // namespace REngine
@@ -1,9 +1,12 @@
 #pragma once
 #include <library/vec2.h>
 #include <core/color.h>
+#include <core/packed_color.h>
 #include <core/camera.h>
+#include <core/texture_atlas.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 
 #include <SFML/Graphics.hpp>
@@ -11,72 +14,120 @@
 namespace REngine
 {
 
-/* Contains functions for drawing */
+/* Contains functions for drawing.
+ * Draws into a RenderWindow, see HeadlessGraphics for the offscreen backend */
 class Graphics
 {
 public:
     using SPtr = std::shared_ptr<Graphics>;
 
+    /* per-frame work counters, reset by Present */
+    struct Counters {
+        uint32_t drawCalls = 0;
+        uint64_t textureUploadBytes = 0;
+        /* views set on the backend, ApplyCamera with the applied camera does not count */
+        uint32_t stateChanges = 0;
+    };
+
 public:
     /* requires RenderWindow pointer, Window's dimensions and Camera object pointer (optionally) */
     Graphics(std::shared_ptr<sf::RenderWindow> win, Vec2<int> ws);
     Graphics(std::shared_ptr<sf::RenderWindow> win, Vec2<int> ws, Camera::SPtr cam);
 
+    virtual ~Graphics() = default;
+
     /* draw a point with given coordinates */
-    void DrawPoint(Vec2<float> pos);
+    virtual void DrawPoint(Vec2<float> pos);
     void DrawPoint(float x, float y);
 
     /* draw a point with given coordinates */
     void DrawCircle(float x, float y, float radius);
-    void DrawCircle(Vec2<float> pos, float radius);
+    virtual void DrawCircle(Vec2<float> pos, float radius);
 
     /* draw broken line fith given verticies */
     void DrawBrokenLine(std::vector<Vec2<float>> t, Vec2<float> a, float s);
 
     /* draw straight line from one point to another */
-    void DrawLine(Vec2<float> v1, Vec2<float> v2);
+    virtual void DrawLine(Vec2<float> v1, Vec2<float> v2);
     void DrawLine(float x1, float y1, float x2, float y2);
 
     /* draw rectangle with given upper left Angle coordinates, width and height */
     void DrawRect(float x, float y, float w, float h);
-    void DrawRect(Vec2<float> pos, Vec2<float> size);
+    virtual void DrawRect(Vec2<float> pos, Vec2<float> size);
 
     /* draw texture with given upper left Angle coordinates, width, height and rotation (rotation center is in the middle) */
     void DrawTexture(sf::Texture& tex, float x, float y, float w, float h);
-    void DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size);
-    void DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size, float a);
+    virtual void DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size);
+    virtual void DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size, float a);
+
+    /* draw CPU-side image centered at pos and stretched to size, the upload is done by the backend */
+    void DrawImage(const sf::Image& image, Vec2<float> pos, Vec2<float> size);
+    /* same for a row-major buffer of imageSize.x * imageSize.y pixels, no sf::Image is needed */
+    virtual void DrawImage(const PackedColor* pixels, Vec2<uint32_t> imageSize, Vec2<float> pos, Vec2<float> size);
+
+    /* draw a batch of vertices with a single draw call, positions are in camera space */
+    virtual void DrawVertices(const sf::Vertex* vertices, size_t count, sf::PrimitiveType type);
+
+    /* draw quads textured from an atlas page with a single draw call, texture coordinates are
+     * in page pixels. The page is uploaded first if it changed, see SpriteBatch */
+    virtual void DrawSprites(TextureAtlas& atlas, uint32_t page, const sf::Vertex* vertices, size_t count);
 
     /* Set color for drawing primitives */
     void SetFillColor(float r, float g, float b, float a);
     void SetFillColor(Color col);
+    void SetFillColor(PackedColor col);
 
-    /* Fill the screen with the same color */
-    void Fill();
+    /* Fill the screen with the same color, an opaque one clears it */
+    virtual void Fill();
 
     /* Clear all */
-    void Clear();
+    virtual void Clear();
 
     /* draw text with given coordinates, size and font */
-    void FillText(const std::string& text, float x, float y, float size, sf::Font& font);
+    virtual void FillText(const std::string& text, float x, float y, float size, sf::Font& font);
 
-    /* auxilary method */
-    void ApplyCamera(Camera::SPtr cam);
+    /* sets the view of the camera, unless it is the one set last. Cameras compare by value */
+    virtual void ApplyCamera(Camera::SPtr cam);
 
     /* Set camera */
     void SetCamera(Camera::SPtr cam);
+    Camera::SPtr GetCamera() const;
 
     /* Set default camera parameters */
     void SetDefaultCamera();
 
     /* update the window */
-    void Present();
+    virtual void Present();
+
+    /* counters of the last presented frame */
+    const Counters& LastFrameCounters() const;
+
+protected:
+    /* view the window would use for the camera */
+    sf::View MakeView(const Camera& cam) const;
+    /* sets the view on the backend */
+    virtual void SetView(const sf::View& view);
+
+    /* ends the frame for the counters */
+    void SwapCounters();
 
-private:
     std::shared_ptr<sf::RenderWindow> _window;
     Color _fillColor;
 
     Camera::SPtr _camera;
+    /* default camera, Fill covers the screen through it */
+    Camera::SPtr _screenCamera = std::make_shared<Camera>();
+    /* camera of the current view, empty until ApplyCamera */
+    std::optional<Camera> _viewCamera;
     Vec2<int> _windowSize;
+
+    Counters _counters;
+    Counters _lastFrameCounters;
+
+private:
+    /* backing texture of DrawImage, created on first use: a texture needs a GL context,
+     * which the headless backend never has */
+    std::unique_ptr<sf::Texture> _imageTexture;
 };
 
-}
\ No newline at end of file
+}
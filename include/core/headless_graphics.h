@@ -0,0 +1,73 @@
+#pragma once
+#include <core/graphics.h>
+
+#include <string>
+#include <vector>
+
+namespace REngine
+{
+
+/* Graphics backend rendering into a CPU framebuffer, needs no window nor GL context.
+ * Meant for display-less benchmarks: primitives, images and atlas sprites are rasterized,
+ * textures and text (which live on the GPU in SFML) are counted but not drawn */
+class HeadlessGraphics : public Graphics
+{
+public:
+    using SPtr = std::shared_ptr<HeadlessGraphics>;
+
+public:
+    HeadlessGraphics(Vec2<int> ws);
+
+    using Graphics::DrawPoint;
+    using Graphics::DrawCircle;
+    using Graphics::DrawLine;
+    using Graphics::DrawRect;
+    using Graphics::DrawTexture;
+    using Graphics::DrawImage;
+
+    void DrawPoint(Vec2<float> pos) override;
+    void DrawCircle(Vec2<float> pos, float radius) override;
+    void DrawLine(Vec2<float> v1, Vec2<float> v2) override;
+    void DrawRect(Vec2<float> pos, Vec2<float> size) override;
+    void DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size) override;
+    void DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size, float a) override;
+    void DrawImage(const PackedColor* pixels, Vec2<uint32_t> imageSize, Vec2<float> pos, Vec2<float> size) override;
+    void DrawVertices(const sf::Vertex* vertices, size_t count, sf::PrimitiveType type) override;
+    void DrawSprites(TextureAtlas& atlas, uint32_t page, const sf::Vertex* vertices, size_t count) override;
+
+    void Fill() override;
+    void Clear() override;
+    void FillText(const std::string& text, float x, float y, float size, sf::Font& font) override;
+    void Present() override;
+
+    /* RGBA8 framebuffer, row-major, Size().x * Size().y pixels */
+    const sf::Uint8* Pixels() const;
+    Vec2<int> Size() const;
+
+    uint32_t PresentedFrames() const;
+
+    /* format is deduced from the extension, as sf::Image::saveToFile */
+    bool SaveToFile(const std::string& path) const;
+
+protected:
+    void SetView(const sf::View& view) override;
+
+private:
+
+    sf::Color FillColor() const;
+    void Blend(int x, int y, sf::Color c);
+
+    /* polygon corners are in pixels, either winding */
+    void FillConvex(const sf::Vector2f* corners, size_t n, sf::Color c);
+    void FillLine(sf::Vector2f a, sf::Vector2f b, sf::Color c);
+
+    std::vector<sf::Uint8> _pixels;
+
+    /* camera space to framebuffer pixels and back */
+    sf::Transform _toPixel;
+    sf::Transform _fromPixel;
+
+    uint32_t _presentedFrames = 0;
+};
+
+}
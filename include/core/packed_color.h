@@ -0,0 +1,55 @@
+#pragma once
+#include <core/color.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace REngine {
+
+/* 4-byte color in r, g, b, a memory order, the pixel layout of sf::Image and textures.
+ * Arithmetic saturates every channel to [0, 255] instead of clamping ints */
+struct PackedColor
+{
+    constexpr PackedColor()
+        : r(0), g(0), b(0), a(255)
+    {}
+    constexpr PackedColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255)
+        : r(r), g(g), b(b), a(a)
+    {}
+    /* Color channels are already clamped */
+    constexpr PackedColor(const Color& c)
+        : r(c.r), g(c.g), b(c.b), a(c.a)
+    {}
+
+    Color ToColor() const;
+
+    /* alpha is taken from the left operand */
+    PackedColor operator+ (PackedColor right) const;
+    PackedColor operator- (PackedColor right) const;
+    /* scales r, g, b, keeps alpha */
+    PackedColor operator* (float right) const;
+
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t a;
+};
+
+static_assert(sizeof(PackedColor) == 4, "PackedColor must stay 4 bytes, it aliases pixel buffers");
+
+/* Bulk operations over spans, vectorized with SSE2 where available.
+ * Results saturate like the PackedColor operators, dst may alias a source */
+
+/* dst[i] = src[i] * factors[i], r, g, b scaled, alpha kept */
+void ScaleColors(const PackedColor* src, const float* factors, PackedColor* dst, size_t count);
+
+/* dst[i] = l[i] + r[i], alpha of l kept */
+void AddColors(const PackedColor* l, const PackedColor* r, PackedColor* dst, size_t count);
+
+/* dst[i] = l[i] + (r[i] - l[i]) * t[i] on all four channels, t in [0, 1] */
+void LerpColors(const PackedColor* l, const PackedColor* r, const float* t, PackedColor* dst, size_t count);
+
+/* packs separate channel planes in [0, 255] scale, out of range values saturate, alpha is 255 */
+void PackColors(const float* r, const float* g, const float* b, PackedColor* dst, size_t count);
+
+} // namespace REngine
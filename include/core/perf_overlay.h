@@ -0,0 +1,59 @@
+#pragma once
+
+#include <core/camera.h>
+#include <core/frame_stats.h>
+#include <core/graphics.h>
+#include <library/vec2.h>
+
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+namespace REngine {
+
+/* Screen-space panel with FPS, frame-time percentiles and a frame-time histogram.
+ * Drawn with one background rect, one vertex batch for the histogram and one text */
+class PerfOverlay {
+public:
+    struct Settings {
+        /* text is skipped when the font can not be loaded, the histogram is still drawn */
+        std::string fontPath = "overlay_font.ttf";
+        Vec2f position = Vec2f{8, 8};
+        float textSize = 13;
+        float lineHeight = 16;
+        float width = 260;
+        float histogramHeight = 48;
+        /* histogram covers [0, histogramRangeMs), slower frames fall into the last bar */
+        float histogramRangeMs = 40;
+    };
+
+public:
+    PerfOverlay();
+    PerfOverlay(Settings settings);
+
+    void Toggle();
+    bool IsVisible() const;
+
+    /* free-form lines shown under the frame stats, e.g. world generation timings */
+    void SetDetails(std::string details);
+
+    void Render(Graphics* gr, const FrameStats& stats, Vec2i screenSize);
+
+private:
+    void BuildHistogram(const FrameStats& stats, Vec2f origin);
+
+    Settings _settings;
+    bool _visible = false;
+
+    sf::Font _font;
+    bool _fontLoaded = false;
+
+    std::string _details;
+    std::string _text;
+    std::vector<sf::Vertex> _vertices;
+
+    Camera::SPtr _screenCamera;
+};
+
+} // namespace REngine
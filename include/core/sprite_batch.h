@@ -0,0 +1,38 @@
+#pragma once
+#include <core/graphics.h>
+#include <core/texture_atlas.h>
+
+#include <vector>
+
+namespace REngine
+{
+
+/* Collects textured quads of TextureAtlas regions and draws them with one DrawSprites call
+ * per atlas page, instead of a texture bind and a draw call for every DrawTexture.
+ * Quads keep the order they were added in within their page, pages are drawn in order */
+class SpriteBatch
+{
+public:
+    explicit SpriteBatch(TextureAtlas& atlas);
+
+    /* region centered at pos and stretched to size */
+    void Draw(const TextureAtlas::Region& region, Vec2<float> pos, Vec2<float> size);
+    /* same, rotated by a radians around its center as the rotated DrawTexture */
+    void Draw(const TextureAtlas::Region& region, Vec2<float> pos, Vec2<float> size, float a);
+
+    /* draws the quads added since the last flush and forgets them, their buffers are kept */
+    void Flush(Graphics& graphics);
+
+    /* quads waiting for the flush */
+    size_t Size() const;
+
+private:
+    void AddQuad(const TextureAtlas::Region& region, const sf::Vector2f (&corners)[4]);
+
+    TextureAtlas& _atlas;
+    /* 4 vertices per quad, by page */
+    std::vector<std::vector<sf::Vertex>> _pages;
+    size_t _size = 0;
+};
+
+}
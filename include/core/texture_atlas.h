@@ -0,0 +1,76 @@
+#pragma once
+#include <library/vec2.h>
+#include <core/packed_color.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+namespace REngine
+{
+
+/* Packs small images into square pages with a skyline packer, so that sprites drawn from
+ * the same page share one texture, see SpriteBatch.
+ * Pixels stay on the CPU, a page is uploaded to its texture when a window backend draws it
+ * after a change. The headless backend samples the CPU pixels and never creates textures */
+class TextureAtlas
+{
+public:
+    static constexpr uint32_t DEFAULT_PAGE_SIZE = 1024;
+    /* transparent border kept around every image, so that neighbours do not bleed in */
+    static constexpr uint32_t PADDING = 1;
+
+    /* place of an image, in pixels of its page */
+    struct Region {
+        uint32_t page;
+        Vec2<uint32_t> position;
+        Vec2<uint32_t> size;
+    };
+
+public:
+    explicit TextureAtlas(uint32_t pageSize = DEFAULT_PAGE_SIZE);
+
+    /* copies a row-major image into the first page it fits in, a new page is opened when
+     * none does. Empty if the image and its padding are larger than a page */
+    std::optional<Region> Add(const PackedColor* pixels, Vec2<uint32_t> size);
+    std::optional<Region> Add(const sf::Image& image);
+
+    uint32_t PageCount() const;
+    uint32_t PageSize() const;
+
+    /* row-major PageSize() * PageSize() pixels */
+    const PackedColor* PagePixels(uint32_t page) const;
+
+    /* uploads the page to its texture if it changed since the last upload, returns the bytes uploaded */
+    uint64_t UploadPage(uint32_t page);
+    /* texture of the page as of the last UploadPage */
+    const sf::Texture& PageTexture(uint32_t page) const;
+
+private:
+    /* top edge of the packed area over [x, x + width) */
+    struct Segment {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+    };
+
+    struct Page {
+        /* left to right, covers the whole width of the page */
+        std::vector<Segment> skyline;
+        std::vector<PackedColor> pixels;
+        std::unique_ptr<sf::Texture> texture;
+        bool dirty = true;
+    };
+
+    /* lowest position for a w * h rectangle, then the narrowest segment, empty if none fits */
+    std::optional<Vec2<uint32_t>> Fit(const Page& page, uint32_t w, uint32_t h, size_t& segment) const;
+    void Place(Page& page, size_t segment, Vec2<uint32_t> position, uint32_t w, uint32_t h);
+    Page& OpenPage();
+
+    uint32_t _pageSize;
+    std::vector<Page> _pages;
+};
+
+}
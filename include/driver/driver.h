@@ -45,4 +45,53 @@ private:
     const Settings _settings;
 };
 
+
+/* Runs a fixed number of frames back to back without sleeping and without waiting for events.
+ * Pair with HeadlessGraphics to benchmark on machines without a display */
+class HeadlessDriver : public Driver {
+public:
+    struct Settings {
+        uint32_t frames;
+        /* passed to Update every frame, independent of wall time so runs are reproducible */
+        float frameDeltaMs;
+        /* frames before the steady state at least. The steady state starts at the first frame
+         * after them that begins settled (Frame::IsSettled), so it does not depend on how fast
+         * the frame builds its content. Allocations of steady frames are reported apart and sampled */
+        uint32_t warmupFrames = 0;
+        /* frames counts the steady frames only, the warmup takes as many frames as settling does */
+        bool framesAfterSettling = false;
+    };
+
+    /* wall time statistics over all frames of the last Run */
+    struct Report {
+        uint32_t frames = 0;
+        double totalMs = 0;
+        double averageUpdateMs = 0;
+        double averageRenderMs = 0;
+        double p50Ms = 0;
+        double p95Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+        /* heap allocations, counted when built with RENGINE_TRACK_ALLOCATIONS */
+        uint64_t allocations = 0;
+        /* 0 if the frame never settled */
+        uint32_t steadyFrames = 0;
+        uint64_t steadyAllocations = 0;
+        uint32_t allocatingSteadyFrames = 0;
+    };
+
+public:
+    HeadlessDriver(Frame::UPtr&& frame, Settings settings);
+
+    void Initialize() override;
+    void Run() override;
+
+    const Report& GetReport() const;
+
+private:
+    Frame::UPtr _frame;
+    const Settings _settings;
+    Report _report;
+};
+
 } // namespace REngine
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Heap allocation tracker.
+//
+// Built with RENGINE_TRACK_ALLOCATIONS (cmake -DRENGINE_TRACK_ALLOCATIONS=ON) it replaces
+// the global operator new and delete with ones that count the allocations of all threads.
+// While sampling, every period-th allocation also records its call stack into a fixed
+// ring, so tracking itself never allocates. Drivers count the allocations of every frame.
+// Without the option nothing is replaced and the counters stay at zero.
+//
+// Over-aligned new (std::align_val_t) is not counted.
+namespace AllocTracker {
+
+struct Counters {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;
+
+    Counters operator-(const Counters& other) const;
+};
+
+constexpr uint32_t MAX_STACK_DEPTH = 16;
+/* samples kept, older ones are overwritten */
+constexpr uint32_t SAMPLE_CAPACITY = 256;
+
+struct Sample {
+    size_t size;
+    uint32_t depth;
+    void* stack[MAX_STACK_DEPTH];
+};
+
+/* whether operator new is replaced by this build */
+bool Enabled();
+
+/* counts since the start of the program */
+Counters Totals();
+
+/* drops the samples so far, from now on every period-th allocation is sampled */
+void StartSampling(uint32_t period);
+void StopSampling();
+
+/* samples in the ring, oldest first */
+std::vector<Sample> CollectSamples();
+
+/* call stacks of the samples, identical ones merged, most frequent first */
+void PrintSamples(std::ostream& out);
+
+} // namespace AllocTracker
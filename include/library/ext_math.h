@@ -7,6 +7,7 @@
 #include <climits>
 
 #include <library/vec2.h>
+#include <library/fast_math.h>
 
 namespace ExtMath {
 
@@ -28,12 +29,19 @@ double Sigmoid(float x, float a);
 
 int Sign(double a);
 
+/* restarts the sequence of RandomDouble and RandomInt, which is seeded with the time otherwise */
+void SeedRandom(uint64_t seed);
+
 double RandomDouble(double a, double b);
 
 int RandomInt(int a, int b);
 
 double Interpolate(double a0, double a1, double p);
-double Smootherstep(double a0, double a1, double p);
+
+template<typename T>
+T Smootherstep(T a0, T a1, T p) {
+    return (a1 - a0) * ((p * (p * 6 - 15) + 10) * p * p * p) + a0;
+}
 
 //   Interpolate values in square's corners and point inside the square
 //
@@ -50,7 +58,11 @@ double Smootherstep(double a0, double a1, double p);
 //   |   0            1
 // 
 double InterpolateSquare(double p00, double p10, double p01, double p11, Vec2<double> p);
-double SmootherstepSquare(double p00, double p10, double p01, double p11, Vec2<double> p);
+
+template<typename T>
+T SmootherstepSquare(T p00, T p10, T p01, T p11, Vec2<T> p) {
+    return Smootherstep(Smootherstep(p00, p10, p.x), Smootherstep(p01, p11, p.x), p.y);
+}
 
 template<typename T = double>
 struct Polynomial {
@@ -59,7 +71,7 @@ struct Polynomial {
     T operator()(T x) const {
         T res = 0;
         for (const auto& [p, a] : coefficients) {
-            res += std::pow(x, p) * a;
+            res += PowInt(x, p) * a;
         }
         return res;
     }
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/* Approximations of <cmath> functions for hot loops where exactness is not required.
+ * Branch-free polynomials with no libm calls (except sqrt in FastAcos), so loops over
+ * them vectorize. The error bounds are the maxima measured over the stated domains */
+namespace ExtMath {
+
+/* x^n by squaring, exact up to rounding of the log2(n) products */
+template <typename T>
+constexpr T PowInt(T x, uint32_t n)
+{
+    T result = 1;
+    while (n != 0) {
+        if (n & 1) {
+            result *= x;
+        }
+        x *= x;
+        n >>= 1;
+    }
+    return result;
+}
+
+namespace FastMathDetail {
+
+// adding 1.5 * 2^52 rounds to the nearest integer, which then sits in the low mantissa bits
+constexpr double ROUND_SHIFT = 6755399441055744.0;
+
+inline int64_t RoundedBits(double shifted)
+{
+    int64_t bits;
+    int64_t base;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    std::memcpy(&base, &ROUND_SHIFT, sizeof(base));
+    return bits - base;
+}
+
+} // namespace FastMathDetail
+
+/* e^x, relative error below 1e-8, x is clamped to [-708, 709] */
+inline double FastExp(double x)
+{
+    constexpr double LOG2E = 1.44269504088896340736;
+    // ln 2 split so that k * LN2_HI is exact
+    constexpr double LN2_HI = 6.93147180369123816490e-01;
+    constexpr double LN2_LO = 1.90821492927058770002e-10;
+
+    x = std::min(std::max(x, -708.), 709.);
+    double shifted = x * LOG2E + FastMathDetail::ROUND_SHIFT;
+    double k = shifted - FastMathDetail::ROUND_SHIFT;
+    double r = x - k * LN2_HI - k * LN2_LO;
+
+    // |r| <= ln2 / 2, Taylor series to r^7
+    double p = 1 + r * (1 + r * (1 / 2. + r * (1 / 6. + r * (1 / 24. + r * (1 / 120. + r * (1 / 720. + r * (1 / 5040.)))))));
+
+    int64_t scaleBits = (FastMathDetail::RoundedBits(shifted) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scaleBits, sizeof(scale));
+    return p * scale;
+}
+
+/* acos(x) in radians, absolute error below 3e-8, x is clamped to [-1, 1]
+ * (Abramowitz and Stegun 4.4.46) */
+inline double FastAcos(double x)
+{
+    constexpr double PI = 3.14159265358979323846;
+
+    double a = std::min(std::abs(x), 1.);
+    double p = -0.0012624911;
+    p = p * a + 0.0066700901;
+    p = p * a - 0.0170881256;
+    p = p * a + 0.0308918810;
+    p = p * a - 0.0501743046;
+    p = p * a + 0.0889789874;
+    p = p * a - 0.2145988016;
+    p = p * a + 1.5707963050;
+    double r = std::sqrt(1 - a) * p;
+    return x < 0 ? PI - r : r;
+}
+
+/* atan2(y, x) in radians, absolute error below 2e-8, 0 for the origin
+ * (Abramowitz and Stegun 4.4.49 on the octant) */
+inline double FastAtan2(double y, double x)
+{
+    constexpr double PI = 3.14159265358979323846;
+
+    double ax = std::abs(x);
+    double ay = std::abs(y);
+    double hi = std::max(ax, ay);
+    double t = hi > 0 ? std::min(ax, ay) / hi : 0;
+    double t2 = t * t;
+    double p = 0.0028662257;
+    p = p * t2 - 0.0161657367;
+    p = p * t2 + 0.0429096138;
+    p = p * t2 - 0.0752896400;
+    p = p * t2 + 0.1065626393;
+    p = p * t2 - 0.1420889944;
+    p = p * t2 + 0.1999355085;
+    p = p * t2 - 0.3333314528;
+    double r = t * (1 + p * t2);
+    r = ay > ax ? PI / 2 - r : r;
+    r = x < 0 ? PI - r : r;
+    return y < 0 ? -r : r;
+}
+
+/* sin(a) and cos(a) at once, absolute error below 1e-11 for |a| < 1e6 */
+inline void FastSinCos(double a, double& s, double& c)
+{
+    constexpr double TWO_OVER_PI = 0.63661977236758134308;
+    // pi / 2 split so that k * PIO2_HI is exact
+    constexpr double PIO2_HI = 1.57079632673412561417e+00;
+    constexpr double PIO2_LO = 6.07710050650619224932e-11;
+
+    double shifted = a * TWO_OVER_PI + FastMathDetail::ROUND_SHIFT;
+    double k = shifted - FastMathDetail::ROUND_SHIFT;
+    int64_t quadrant = FastMathDetail::RoundedBits(shifted);
+    double r = a - k * PIO2_HI - k * PIO2_LO;
+
+    // |r| <= pi / 4, Taylor series to r^11 and r^12
+    double r2 = r * r;
+    double sr = r + r * r2 * (-1 / 6. + r2 * (1 / 120. + r2 * (-1 / 5040. + r2 * (1 / 362880. + r2 * (-1 / 39916800.)))));
+    double cr = 1 + r2 * (-1 / 2. + r2 * (1 / 24. + r2 * (-1 / 720. + r2 * (1 / 40320. + r2 * (-1 / 3628800. + r2 * (1 / 479001600.))))));
+
+    // sin(r + k pi/2) and cos(r + k pi/2) by the quadrant k mod 4
+    s = (quadrant & 1) ? cr : sr;
+    c = (quadrant & 1) ? sr : cr;
+    s = (quadrant & 2) ? -s : s;
+    c = ((quadrant + 1) & 2) ? -c : c;
+}
+
+} // namespace ExtMath
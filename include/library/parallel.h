@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+// Data-parallel loops over a process-wide pool of worker threads.
+//
+// The pool is started on first use with one worker less than the hardware
+// concurrency, the calling thread takes chunks too. For calls issued from inside
+// a For body run inline on the calling thread, so nesting never deadlocks.
+namespace Parallel {
+
+/* Non-owning reference to a callable taking (chunkBegin, chunkEnd). Unlike a std::function
+ * it does not allocate for lambdas with many captures, the callable outlives the For */
+class Body {
+public:
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Body>>>
+    Body(F&& body)
+        : _body(const_cast<void*>(static_cast<const void*>(&body)))
+        , _call(&Call<std::remove_reference_t<F>>)
+    {}
+
+    void operator()(size_t chunkBegin, size_t chunkEnd) const {
+        _call(_body, chunkBegin, chunkEnd);
+    }
+
+private:
+    template<typename F>
+    static void Call(void* body, size_t chunkBegin, size_t chunkEnd) {
+        (*static_cast<F*>(body))(chunkBegin, chunkEnd);
+    }
+
+    void* _body;
+    void (*_call)(void*, size_t, size_t);
+};
+
+/* Threads a For is spread over, the caller included */
+size_t ThreadCount();
+
+/* Calls body(chunkBegin, chunkEnd) on disjoint chunks covering [begin, end) and returns
+ * when all of them are done. Chunks hold at least grain items; bodies run concurrently */
+void For(size_t begin, size_t end, size_t grain, Body body);
+
+} // namespace Parallel
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped-zone profiler.
+//
+// Zones are recorded into a fixed-size ring buffer owned by the calling thread,
+// so recording never locks and never allocates after the first zone of a thread.
+// Use PROFILE_SCOPE("name") / PROFILE_FUNCTION() instead of ScopedZone directly:
+// the macros compile to nothing unless RENGINE_PROFILER_ENABLED is defined
+// (cmake -DRENGINE_ENABLE_PROFILER=ON, the default).
+//
+// Zone names must be string literals (or otherwise outlive the profiler),
+// only the pointer is stored.
+namespace Profiler {
+
+struct Event {
+    const char* name;
+    int64_t startNs;
+    int64_t durationNs;
+    uint32_t depth;
+    uint32_t threadId;
+};
+
+/* Zones kept per thread, older ones are overwritten */
+constexpr uint32_t RING_CAPACITY = 1 << 16;
+
+/* Nanoseconds since the first call to the profiler */
+int64_t NowNs();
+
+/* Append a finished zone to the calling thread's ring buffer */
+void Record(const char* name, int64_t startNs, int64_t endNs, uint32_t depth);
+
+/* Snapshot of all buffered zones of all threads, sorted by start time.
+ * Zones being recorded concurrently may be missed, collect between frames */
+std::vector<Event> Collect();
+
+/* Drop all buffered zones */
+void Clear();
+
+/* Write buffered zones in Chrome trace format (chrome://tracing, ui.perfetto.dev) */
+bool ExportChromeTrace(const std::string& path);
+
+class ScopedZone {
+public:
+    explicit ScopedZone(const char* name);
+    ~ScopedZone();
+
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+    const char* _name;
+    uint32_t _depth;
+    int64_t _startNs;
+};
+
+} // namespace Profiler
+
+#ifdef RENGINE_PROFILER_ENABLED
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ::Profiler::ScopedZone PROFILE_CONCAT(__profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#endif
@@ -1,68 +1,65 @@
 #pragma once
 #include <cmath>
 #include <iostream>
+#include <type_traits>
 
-/* T must be algebraic field */
-template <typename T, class F = float>
+/* T must be algebraic field, F is the type of lengths and angles (T itself for floating T) */
+template <typename T, class F = std::conditional_t<std::is_floating_point<T>::value, T, float>>
 struct Vec2
 {
-    Vec2();
+    constexpr Vec2();
     template<typename T1>
-    Vec2(T1 x, T1 y);
+    constexpr Vec2(T1 x, T1 y);
     template<typename T1, typename F1>
-    Vec2(const Vec2<T1, F1>& other);
-    template<typename T1, typename F1>
-    Vec2(Vec2<T1, F1>&& other);
+    constexpr Vec2(const Vec2<T1, F1>& other);
     
     /* comparison without eps, be careful with floating types */
     template<typename T1, typename F1>
-    bool operator==(const Vec2<T1, F1>& other) const;
+    constexpr bool operator==(const Vec2<T1, F1>& other) const;
     template<typename T1, typename F1>
-    bool operator!=(const Vec2<T1, F1>& other) const;
+    constexpr bool operator!=(const Vec2<T1, F1>& other) const;
 
     /* true if this' and other's coordinates differerence is no more than eps */
     template<typename T1, typename F1>
     bool compare_with_eps(const Vec2<T1, F1>& other) const;
 
     template<typename T1, typename F1>
-    Vec2& operator=(const Vec2<T1, F1>& other);
-    template<typename T1, typename F1>
-    Vec2& operator=(Vec2<T1, F1>&& other);
+    constexpr Vec2& operator=(const Vec2<T1, F1>& other);
 
     template<typename T1, typename T2>
-    void Set(T1 x, T2 y);
+    constexpr void Set(T1 x, T2 y);
 
-    Vec2 operator-() const;
+    constexpr Vec2 operator-() const;
 
     template <typename T1, typename F1>
-    Vec2& operator+=(Vec2<T1, F1> r);
+    constexpr Vec2& operator+=(Vec2<T1, F1> r);
     template <typename T1, typename F1>
-    Vec2& operator-=(Vec2<T1, F1> r);
+    constexpr Vec2& operator-=(Vec2<T1, F1> r);
 
     template <typename T1>
-    Vec2& operator*=(T1 r);
+    constexpr Vec2& operator*=(T1 r);
     template <typename T1>
-    Vec2& operator/=(T1 r);
+    constexpr Vec2& operator/=(T1 r);
 
     template <typename T1, typename F1>
-    Vec2& operator*=(Vec2<T1, F1> r);
+    constexpr Vec2& operator*=(Vec2<T1, F1> r);
     template <typename T1, typename F1>
-    Vec2& operator/=(Vec2<T1, F1> r);
+    constexpr Vec2& operator/=(Vec2<T1, F1> r);
 
     template <typename T1, typename F1>
-    Vec2 operator+(Vec2<T1, F1> r) const;
+    constexpr Vec2 operator+(Vec2<T1, F1> r) const;
     template <typename T1, typename F1>
-    Vec2 operator-(Vec2<T1, F1> r) const;
+    constexpr Vec2 operator-(Vec2<T1, F1> r) const;
 
     template <typename T1>
-    Vec2 operator*(T1 r) const;
+    constexpr Vec2 operator*(T1 r) const;
     template <typename T1>
-    Vec2 operator/(T1 r) const;
+    constexpr Vec2 operator/(T1 r) const;
 
     template <typename T1, typename F1>
-    Vec2 operator*(Vec2<T1, F1> r) const;
+    constexpr Vec2 operator*(Vec2<T1, F1> r) const;
     template <typename T1, typename F1>
-    Vec2 operator/(Vec2<T1, F1> r) const;
+    constexpr Vec2 operator/(Vec2<T1, F1> r) const;
 
     F magnitude() const;
     Vec2 normalized() const;
@@ -81,13 +78,15 @@ using Vec2u = Vec2<uint32_t>;
 using Vec2f = Vec2<float>;
 using Vec2d = Vec2<double>;
 
+static_assert(std::is_trivially_copyable<Vec2d>::value, "Vec2 is copied as plain memory");
+
  /* returns scalar product */
 template <typename T, typename F>
-T dot_prod(const Vec2<T, F>& l, const Vec2<T, F>& r);
+constexpr T dot_prod(const Vec2<T, F>& l, const Vec2<T, F>& r);
 
 /* returns vector product = |x|*|y|*sin(angle(x,y)) */
 template <typename T, typename F>
-T cross_prod(const Vec2<T, F>& l, const Vec2<T, F>& r);
+constexpr T cross_prod(const Vec2<T, F>& l, const Vec2<T, F>& r);
 
 /* returns distance between point a and b */
 template <typename T, typename F>
@@ -114,41 +113,32 @@ std::ostream& operator<<(std::ostream& out, const Vec2<T, F>& v);
 /* =========================================================================== */
 
 template <typename T, typename F>
-Vec2<T, F>::Vec2()
+constexpr Vec2<T, F>::Vec2()
     : x(0), y(0)
 {}
 
 template <typename T, typename F>
 template<typename T1>
-Vec2<T, F>::Vec2(T1 x, T1 y)
+constexpr Vec2<T, F>::Vec2(T1 x, T1 y)
     : x(x), y(y)
 {}
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1>::Vec2(const Vec2<T2, F2>& other)
+constexpr Vec2<T1, F1>::Vec2(const Vec2<T2, F2>& other)
     : x(other.x), y(other.y)
 {}
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1>::Vec2(Vec2<T2, F2>&& other)
-    : x(other.x), y(other.y)
-{
-    other.x = 0;
-    other.y = 0;
-}
-
-template<typename T1, typename F1>
-template<typename T2, typename F2>
-bool Vec2<T1, F1>::operator==(const Vec2<T2, F2>& other) const
+constexpr bool Vec2<T1, F1>::operator==(const Vec2<T2, F2>& other) const
 {
     return (x == other.x && y == other.y);
 }
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-bool Vec2<T1, F1>::operator!=(const Vec2<T2, F2>& other) const
+constexpr bool Vec2<T1, F1>::operator!=(const Vec2<T2, F2>& other) const
 {
     return (x != other.x || y != other.y);
 }
@@ -162,17 +152,7 @@ bool Vec2<T1, F1>::compare_with_eps(const Vec2<T2, F2>& other) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1>& Vec2<T1, F1>::operator=(const Vec2<T2, F2>& other)
-{
-    x = other.x;
-    y = other.y;
-
-    return *this;
-}
-
-template<typename T1, typename F1>
-template<typename T2, typename F2>
-Vec2<T1, F1>& Vec2<T1, F1>::operator=(Vec2<T2, F2>&& other)
+constexpr Vec2<T1, F1>& Vec2<T1, F1>::operator=(const Vec2<T2, F2>& other)
 {
     x = other.x;
     y = other.y;
@@ -182,21 +162,21 @@ Vec2<T1, F1>& Vec2<T1, F1>::operator=(Vec2<T2, F2>&& other)
 
 template<typename T, typename F>
 template<typename T1, typename T2>
-void Vec2<T, F>::Set(T1 x, T2 y)
+constexpr void Vec2<T, F>::Set(T1 x, T2 y)
 {
     this->x = x;
     this->y = y;
 }
 
 template<typename T, typename F>
-Vec2<T, F> Vec2<T, F>::operator-() const
+constexpr Vec2<T, F> Vec2<T, F>::operator-() const
 {
     return Vec2(-x, -y);
 }
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1>& Vec2<T1, F1>::operator+=(Vec2<T2, F2> r)
+constexpr Vec2<T1, F1>& Vec2<T1, F1>::operator+=(Vec2<T2, F2> r)
 {
     x += r.x;
     y += r.y;
@@ -205,14 +185,14 @@ Vec2<T1, F1>& Vec2<T1, F1>::operator+=(Vec2<T2, F2> r)
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1>& Vec2<T1, F1>::operator-=(Vec2<T2, F2> r)
+constexpr Vec2<T1, F1>& Vec2<T1, F1>::operator-=(Vec2<T2, F2> r)
 {
     return *this += -r;
 }
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1>& Vec2<T1, F1>::operator*=(Vec2<T2, F2> r)
+constexpr Vec2<T1, F1>& Vec2<T1, F1>::operator*=(Vec2<T2, F2> r)
 {
     x *= r.x;
     y *= r.y;
@@ -221,7 +201,7 @@ Vec2<T1, F1>& Vec2<T1, F1>::operator*=(Vec2<T2, F2> r)
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1>& Vec2<T1, F1>::operator/=(Vec2<T2, F2> r)
+constexpr Vec2<T1, F1>& Vec2<T1, F1>::operator/=(Vec2<T2, F2> r)
 {
     x /= r.x;
     y /= r.y;
@@ -230,7 +210,7 @@ Vec2<T1, F1>& Vec2<T1, F1>::operator/=(Vec2<T2, F2> r)
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1> Vec2<T1, F1>::operator+(Vec2<T2, F2> r) const
+constexpr Vec2<T1, F1> Vec2<T1, F1>::operator+(Vec2<T2, F2> r) const
 {
     Vec2 v(*this);
     return v += r;
@@ -238,7 +218,7 @@ Vec2<T1, F1> Vec2<T1, F1>::operator+(Vec2<T2, F2> r) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1> Vec2<T1, F1>::operator-(Vec2<T2, F2> r) const
+constexpr Vec2<T1, F1> Vec2<T1, F1>::operator-(Vec2<T2, F2> r) const
 {
     Vec2 v(*this);
     return v -= r;
@@ -246,7 +226,7 @@ Vec2<T1, F1> Vec2<T1, F1>::operator-(Vec2<T2, F2> r) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1> Vec2<T1, F1>::operator*(Vec2<T2, F2> r) const
+constexpr Vec2<T1, F1> Vec2<T1, F1>::operator*(Vec2<T2, F2> r) const
 {
     Vec2 v(*this);
     return v *= r;
@@ -254,7 +234,7 @@ Vec2<T1, F1> Vec2<T1, F1>::operator*(Vec2<T2, F2> r) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec2<T1, F1> Vec2<T1, F1>::operator/(Vec2<T2, F2> r) const
+constexpr Vec2<T1, F1> Vec2<T1, F1>::operator/(Vec2<T2, F2> r) const
 {
     Vec2 v(*this);
     return v /= r;
@@ -288,7 +268,7 @@ inline Vec2<T, F> Vec2<T, F>::rotated(F1 a) const
 
 template<typename T, typename F>
 template<typename T1>
-Vec2<T, F>& Vec2<T, F>::operator*=(T1 r)
+constexpr Vec2<T, F>& Vec2<T, F>::operator*=(T1 r)
 {
     x *= r;
     y *= r;
@@ -297,14 +277,14 @@ Vec2<T, F>& Vec2<T, F>::operator*=(T1 r)
 
 template<typename T, typename F>
 template<typename T1>
-Vec2<T, F>& Vec2<T, F>::operator/=(T1 r)
+constexpr Vec2<T, F>& Vec2<T, F>::operator/=(T1 r)
 {
     return *this *= 1 / r;
 }
 
 template<typename T, typename F>
 template<typename T1>
-Vec2<T, F> Vec2<T, F>::operator*(T1 r) const
+constexpr Vec2<T, F> Vec2<T, F>::operator*(T1 r) const
 {
     Vec2 v(*this);
     return v *= r;
@@ -313,7 +293,7 @@ Vec2<T, F> Vec2<T, F>::operator*(T1 r) const
 
 template<typename T, typename F>
 template<typename T1>
-Vec2<T, F> Vec2<T, F>::operator/(T1 r) const
+constexpr Vec2<T, F> Vec2<T, F>::operator/(T1 r) const
 {
     Vec2 v(*this);
     return v /= r;
@@ -334,13 +314,13 @@ std::ostream& operator<<(std::ostream& out, const Vec2<T, F>& v)
 }
 
 template<typename T, typename F>
-T dot_prod(const Vec2<T, F>& l, const Vec2<T, F>& r)
+constexpr T dot_prod(const Vec2<T, F>& l, const Vec2<T, F>& r)
 {
     return l.x * r.x + l.y * r.y;
 }
 
 template<typename T, typename F>
-T cross_prod(const Vec2<T, F>& l, const Vec2<T, F>& r)
+constexpr T cross_prod(const Vec2<T, F>& l, const Vec2<T, F>& r)
 {
     return l.x * r.y - l.y * r.x;
 }
@@ -348,7 +328,7 @@ T cross_prod(const Vec2<T, F>& l, const Vec2<T, F>& r)
 template<typename T, typename F>
 F dist(const Vec2<T, F>& a, const Vec2<T, F>& b)
 {
-    return (a - b).abs();
+    return (a - b).magnitude();
 }
 
 template<typename T, typename F>
@@ -360,8 +340,8 @@ F angle(const Vec2<T, F>& a, const Vec2<T, F>& b)
 template<typename T, typename F>
 bool check_parallel(const Vec2<T, F>& a, const Vec2<T, F>& b)
 {
-    double aabs = a.abs();
-    double babs = b.abs();
+    F aabs = a.magnitude();
+    F babs = b.magnitude();
 
     if (aabs < Vec2<T, F>::EPS || babs < Vec2<T, F>::EPS)
     {
@@ -1,68 +1,65 @@
 #pragma once
 #include <cmath>
 #include <iostream>
+#include <type_traits>
 
-/* T must be algebraic field */
-template <typename T, class F = float>
+/* T must be algebraic field, F is the type of lengths and angles (T itself for floating T) */
+template <typename T, class F = std::conditional_t<std::is_floating_point<T>::value, T, float>>
 struct Vec3
 {
-    Vec3();
+    constexpr Vec3();
     template<typename T1, typename T2, typename T3>
-    Vec3(T1 x, T2 y, T3 z);
+    constexpr Vec3(T1 x, T2 y, T3 z);
     template<typename T1, typename F1>
-    Vec3(const Vec3<T1, F1>& other);
-    template<typename T1, typename F1>
-    Vec3(Vec3<T1, F1>&& other);
+    constexpr Vec3(const Vec3<T1, F1>& other);
     
     /* comparison without eps, be careful with floating types */
     template<typename T1, typename F1>
-    bool operator==(const Vec3<T1, F1>& other) const;
+    constexpr bool operator==(const Vec3<T1, F1>& other) const;
     template<typename T1, typename F1>
-    bool operator!=(const Vec3<T1, F1>& other) const;
+    constexpr bool operator!=(const Vec3<T1, F1>& other) const;
 
     /* true if this' and other's coordinates differerence is no more than eps */
     template<typename T1, typename F1>
     bool compare_with_eps(const Vec3<T1, F1>& other) const;
 
     template<typename T1, typename F1>
-    Vec3& operator=(const Vec3<T1, F1>& other);
-    template<typename T1, typename F1>
-    Vec3& operator=(Vec3<T1, F1>&& other);
+    constexpr Vec3& operator=(const Vec3<T1, F1>& other);
 
     template<typename T1, typename T2, typename T3>
-    void Set(T1 x, T2 y, T3 z);
+    constexpr void Set(T1 x, T2 y, T3 z);
 
-    Vec3 operator-() const;
+    constexpr Vec3 operator-() const;
 
     template <typename T1, typename F1>
-    Vec3& operator+=(Vec3<T1, F1> r);
+    constexpr Vec3& operator+=(Vec3<T1, F1> r);
     template <typename T1, typename F1>
-    Vec3& operator-=(Vec3<T1, F1> r);
+    constexpr Vec3& operator-=(Vec3<T1, F1> r);
 
     template <typename T1>
-    Vec3& operator*=(T1 r);
+    constexpr Vec3& operator*=(T1 r);
     template <typename T1>
-    Vec3& operator/=(T1 r);
+    constexpr Vec3& operator/=(T1 r);
 
     template <typename T1, typename F1>
-    Vec3& operator*=(Vec3<T1, F1> r);
+    constexpr Vec3& operator*=(Vec3<T1, F1> r);
     template <typename T1, typename F1>
-    Vec3& operator/=(Vec3<T1, F1> r);
+    constexpr Vec3& operator/=(Vec3<T1, F1> r);
 
     template <typename T1, typename F1>
-    Vec3 operator+(Vec3<T1, F1> r) const;
+    constexpr Vec3 operator+(Vec3<T1, F1> r) const;
     template <typename T1, typename F1>
-    Vec3 operator-(Vec3<T1, F1> r) const;
+    constexpr Vec3 operator-(Vec3<T1, F1> r) const;
 
     template <typename T1>
-    Vec3 operator*(T1 r) const;
+    constexpr Vec3 operator*(T1 r) const;
     template <typename T1>
-    Vec3 operator/(T1 r) const;
+    constexpr Vec3 operator/(T1 r) const;
 
     template <typename T1, typename F1>
-    Vec3 operator*(Vec3<T1, F1> r) const;
+    constexpr Vec3 operator*(Vec3<T1, F1> r) const;
     template <typename T1, typename F1>
-    Vec3 operator/(Vec3<T1, F1> r) const;
+    constexpr Vec3 operator/(Vec3<T1, F1> r) const;
 
     F magnitude() const;
     Vec3 normalized() const;
@@ -78,13 +75,15 @@ using Vec3i = Vec3<int>;
 using Vec3f = Vec3<float>;
 using Vec3d = Vec3<double>;
 
+static_assert(std::is_trivially_copyable<Vec3d>::value, "Vec3 is copied as plain memory");
+
  /* returns scalar product */
 template <typename T, typename F>
-T dot_prod(const Vec3<T, F>& l, const Vec3<T, F>& r);
+constexpr T dot_prod(const Vec3<T, F>& l, const Vec3<T, F>& r);
 
  /* returns vector product */
 template <typename T, typename F>
-Vec3<T, F> cross_prod(const Vec3<T, F>& l, const Vec3<T, F>& r);
+constexpr Vec3<T, F> cross_prod(const Vec3<T, F>& l, const Vec3<T, F>& r);
 
 /* returns distance between points a and b */
 template <typename T, typename F>
@@ -104,49 +103,39 @@ template <typename T, typename F>
 std::istream& operator>>(std::istream& in, Vec3<T, F>& v);
 
 template <typename T, typename F>
-std::ostream& operator<<(std::ostream& out, const Vec3<T, F>& v);\
+std::ostream& operator<<(std::ostream& out, const Vec3<T, F>& v);
 
 /* =========================================================================== */
 /* =============================== DEFINITIONS =============================== */
 /* =========================================================================== */
 
 template <typename T, typename F>
-Vec3<T, F>::Vec3()
+constexpr Vec3<T, F>::Vec3()
     : x(0), y(0), z(0)
 {}
 
 template <typename T, typename F>
 template<typename T1, typename T2, typename T3>
-Vec3<T, F>::Vec3(T1 x, T2 y, T3 z)
+constexpr Vec3<T, F>::Vec3(T1 x, T2 y, T3 z)
     : x(x), y(y), z(z)
 {}
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1>::Vec3(const Vec3<T2, F2>& other)
+constexpr Vec3<T1, F1>::Vec3(const Vec3<T2, F2>& other)
     : x(other.x), y(other.y), z(other.z)
 {}
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1>::Vec3(Vec3<T2, F2>&& other)
-    : x(other.x), y(other.y), z(other.z)
-{
-    other.x = 0;
-    other.y = 0;
-    other.z = 0;
-}
-
-template<typename T1, typename F1>
-template<typename T2, typename F2>
-bool Vec3<T1, F1>::operator==(const Vec3<T2, F2>& other) const
+constexpr bool Vec3<T1, F1>::operator==(const Vec3<T2, F2>& other) const
 {
     return (x == other.x && y == other.y && z == other.z);
 }
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-bool Vec3<T1, F1>::operator!=(const Vec3<T2, F2>& other) const
+constexpr bool Vec3<T1, F1>::operator!=(const Vec3<T2, F2>& other) const
 {
     return (x != other.x || y != other.y || z != other.z);
 }
@@ -162,18 +151,7 @@ bool Vec3<T1, F1>::compare_with_eps(const Vec3<T2, F2>& other) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1>& Vec3<T1, F1>::operator=(const Vec3<T2, F2>& other)
-{
-    x = other.x;
-    y = other.y;
-    z = other.z;
-
-    return *this;
-}
-
-template<typename T1, typename F1>
-template<typename T2, typename F2>
-Vec3<T1, F1>& Vec3<T1, F1>::operator=(Vec3<T2, F2>&& other)
+constexpr Vec3<T1, F1>& Vec3<T1, F1>::operator=(const Vec3<T2, F2>& other)
 {
     x = other.x;
     y = other.y;
@@ -184,7 +162,7 @@ Vec3<T1, F1>& Vec3<T1, F1>::operator=(Vec3<T2, F2>&& other)
 
 template<typename T, typename F>
 template<typename T1, typename T2, typename T3>
-void Vec3<T, F>::Set(T1 x, T2 y, T3 z)
+constexpr void Vec3<T, F>::Set(T1 x, T2 y, T3 z)
 {
     this->x = x;
     this->y = y;
@@ -192,14 +170,14 @@ void Vec3<T, F>::Set(T1 x, T2 y, T3 z)
 }
 
 template<typename T, typename F>
-Vec3<T, F> Vec3<T, F>::operator-() const
+constexpr Vec3<T, F> Vec3<T, F>::operator-() const
 {
     return Vec3(-x, -y, -z);
 }
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1>& Vec3<T1, F1>::operator+=(Vec3<T2, F2> r)
+constexpr Vec3<T1, F1>& Vec3<T1, F1>::operator+=(Vec3<T2, F2> r)
 {
     x += r.x;
     y += r.y;
@@ -209,14 +187,14 @@ Vec3<T1, F1>& Vec3<T1, F1>::operator+=(Vec3<T2, F2> r)
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1>& Vec3<T1, F1>::operator-=(Vec3<T2, F2> r)
+constexpr Vec3<T1, F1>& Vec3<T1, F1>::operator-=(Vec3<T2, F2> r)
 {
     return *this += -r;
 }
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1>& Vec3<T1, F1>::operator*=(Vec3<T2, F2> r)
+constexpr Vec3<T1, F1>& Vec3<T1, F1>::operator*=(Vec3<T2, F2> r)
 {
     x *= r.x;
     y *= r.y;
@@ -226,7 +204,7 @@ Vec3<T1, F1>& Vec3<T1, F1>::operator*=(Vec3<T2, F2> r)
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1>& Vec3<T1, F1>::operator/=(Vec3<T2, F2> r)
+constexpr Vec3<T1, F1>& Vec3<T1, F1>::operator/=(Vec3<T2, F2> r)
 {
     x /= r.x;
     y /= r.y;
@@ -236,7 +214,7 @@ Vec3<T1, F1>& Vec3<T1, F1>::operator/=(Vec3<T2, F2> r)
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1> Vec3<T1, F1>::operator+(Vec3<T2, F2> r) const
+constexpr Vec3<T1, F1> Vec3<T1, F1>::operator+(Vec3<T2, F2> r) const
 {
     Vec3 v(*this);
     return v += r;
@@ -244,7 +222,7 @@ Vec3<T1, F1> Vec3<T1, F1>::operator+(Vec3<T2, F2> r) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1> Vec3<T1, F1>::operator-(Vec3<T2, F2> r) const
+constexpr Vec3<T1, F1> Vec3<T1, F1>::operator-(Vec3<T2, F2> r) const
 {
     Vec3 v(*this);
     return v -= r;
@@ -252,7 +230,7 @@ Vec3<T1, F1> Vec3<T1, F1>::operator-(Vec3<T2, F2> r) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1> Vec3<T1, F1>::operator*(Vec3<T2, F2> r) const
+constexpr Vec3<T1, F1> Vec3<T1, F1>::operator*(Vec3<T2, F2> r) const
 {
     Vec3 v(*this);
     return v *= r;
@@ -260,7 +238,7 @@ Vec3<T1, F1> Vec3<T1, F1>::operator*(Vec3<T2, F2> r) const
 
 template<typename T1, typename F1>
 template<typename T2, typename F2>
-Vec3<T1, F1> Vec3<T1, F1>::operator/(Vec3<T2, F2> r) const
+constexpr Vec3<T1, F1> Vec3<T1, F1>::operator/(Vec3<T2, F2> r) const
 {
     Vec3 v(*this);
     return v /= r;
@@ -285,7 +263,7 @@ Vec3<T, F> Vec3<T, F>::normalized() const
 
 template<typename T, typename F>
 template<typename T1>
-Vec3<T, F>& Vec3<T, F>::operator*=(T1 r)
+constexpr Vec3<T, F>& Vec3<T, F>::operator*=(T1 r)
 {
     x *= r;
     y *= r;
@@ -295,14 +273,14 @@ Vec3<T, F>& Vec3<T, F>::operator*=(T1 r)
 
 template<typename T, typename F>
 template<typename T1>
-Vec3<T, F>& Vec3<T, F>::operator/=(T1 r)
+constexpr Vec3<T, F>& Vec3<T, F>::operator/=(T1 r)
 {
     return *this *= 1 / r;
 }
 
 template<typename T, typename F>
 template<typename T1>
-Vec3<T, F> Vec3<T, F>::operator*(T1 r) const
+constexpr Vec3<T, F> Vec3<T, F>::operator*(T1 r) const
 {
     Vec3 v(*this);
     return v *= r;
@@ -311,7 +289,7 @@ Vec3<T, F> Vec3<T, F>::operator*(T1 r) const
 
 template<typename T, typename F>
 template<typename T1>
-Vec3<T, F> Vec3<T, F>::operator/(T1 r) const
+constexpr Vec3<T, F> Vec3<T, F>::operator/(T1 r) const
 {
     Vec3 v(*this);
     return v /= r;
@@ -332,17 +310,17 @@ std::ostream& operator<<(std::ostream& out, const Vec3<T, F>& v)
 }
 
 template<typename T, typename F>
-T dot_prod(const Vec3<T, F>& l, const Vec3<T, F>& r)
+constexpr T dot_prod(const Vec3<T, F>& l, const Vec3<T, F>& r)
 {
     return l.x * r.x + l.y * r.y + l.z * r.z;
 }
 
 template<typename T, typename F>
-Vec3<T, F> cross_prod(const Vec3<T, F>& l, const Vec3<T, F>& r)
+constexpr Vec3<T, F> cross_prod(const Vec3<T, F>& l, const Vec3<T, F>& r)
 {
     return Vec3<T, F>{
         l.y * r.z - l.z * r.y,
-        l.x * r.z - l.z * r.x,
+        l.z * r.x - l.x * r.z,
         l.x * r.y - l.y * r.x
     };
 }
@@ -356,24 +334,24 @@ F dist(const Vec3<T, F>& a, const Vec3<T, F>& b)
 template<typename T, typename F>
 F angle(const Vec3<T, F>& a, const Vec3<T, F>& b)
 {
-    double amag = a.magnitude();
-    double bmag = b.magnitude();
+    F amag = a.magnitude();
+    F bmag = b.magnitude();
     if (amag < Vec3<T, F>::EPS || bmag < Vec3<T, F>::EPS) {
         return 0;
     }
-    return std::acos(dot_prod(a, b) / a.magnitude() / b.magnitude());
+    return std::acos(dot_prod(a, b) / amag / bmag);
 }
 
 template<typename T, typename F>
 bool check_parallel(const Vec3<T, F>& a, const Vec3<T, F>& b)
 {
-    double amag = a.magnitude();
-    double bmag = b.magnitude();
+    F amag = a.magnitude();
+    F bmag = b.magnitude();
 
     if (amag < Vec3<T, F>::EPS || bmag < Vec3<T, F>::EPS)
     {
         return true;
     }
 
-    return (std::abs(cross_prod(a, b) / amag / bmag) < Vec3<T, F>::EPS);
+    return (cross_prod(a, b).magnitude() / amag / bmag < Vec3<T, F>::EPS);
 }
@@ -0,0 +1,219 @@
+#pragma once
+#include <library/vec3.h>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Non-owning view of size vectors stored as three coordinate arrays,
+ * T is const for read-only views */
+template <typename T>
+struct Vec3Span
+{
+    constexpr Vec3Span(T* x, T* y, T* z, size_t size)
+        : x(x), y(y), z(z), size(size)
+    {}
+    /* mutable view to read-only view */
+    template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+    constexpr Vec3Span(const Vec3Span<U>& other)
+        : x(other.x), y(other.y), z(other.z), size(other.size)
+    {}
+
+    Vec3<std::remove_const_t<T>> get(size_t i) const {
+        return {x[i], y[i], z[i]};
+    }
+
+    void set(size_t i, const Vec3<std::remove_const_t<T>>& v) const {
+        x[i] = v.x;
+        y[i] = v.y;
+        z[i] = v.z;
+    }
+
+    Vec3Span sub(size_t begin, size_t count) const {
+        return Vec3Span(x + begin, y + begin, z + begin, count);
+    }
+
+    T* x;
+    T* y;
+    T* z;
+    size_t size;
+};
+
+/* Structure-of-arrays container of Vec3, whole rows are processed by the span functions below.
+ * Allocator allocates the coordinate arrays */
+template <typename T, typename Allocator = std::allocator<T>>
+struct Vec3Batch
+{
+    size_t size() const {
+        return x.size();
+    }
+
+    void resize(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+    }
+
+    void assign(size_t n, const Vec3<T>& v) {
+        x.assign(n, v.x);
+        y.assign(n, v.y);
+        z.assign(n, v.z);
+    }
+
+    Vec3<T> get(size_t i) const {
+        return {x[i], y[i], z[i]};
+    }
+
+    void set(size_t i, const Vec3<T>& v) {
+        x[i] = v.x;
+        y[i] = v.y;
+        z[i] = v.z;
+    }
+
+    Vec3Span<T> span() {
+        return Vec3Span<T>(x.data(), y.data(), z.data(), size());
+    }
+    Vec3Span<const T> span() const {
+        return Vec3Span<const T>(x.data(), y.data(), z.data(), size());
+    }
+    Vec3Span<T> span(size_t begin, size_t count) {
+        return span().sub(begin, count);
+    }
+    Vec3Span<const T> span(size_t begin, size_t count) const {
+        return span().sub(begin, count);
+    }
+
+    std::vector<T, Allocator> x;
+    std::vector<T, Allocator> y;
+    std::vector<T, Allocator> z;
+};
+
+/* T of the span functions is deduced from the output, inputs convert from mutable spans */
+template <typename T>
+struct Vec3SpanIn_ {
+    using type = Vec3Span<const T>;
+};
+template <typename T>
+using Vec3SpanIn = typename Vec3SpanIn_<T>::type;
+
+/* out[i] = dot_prod(a[i], b) */
+template <typename T, typename F>
+void dot_prod(Vec3SpanIn<T> a, const Vec3<T, F>& b, T* out);
+
+/* out[i] = dot_prod(a[i], b[i]) */
+template <typename T>
+void dot_prod(Vec3SpanIn<T> a, Vec3SpanIn<T> b, T* out);
+
+/* out[i] = cross_prod(a[i], b[i]), out may alias an input */
+template <typename T>
+void cross_prod(Vec3SpanIn<T> a, Vec3SpanIn<T> b, Vec3Span<T> out);
+
+/* v[i] = v[i].normalized(), vectors shorter than Vec3::EPS are kept as is */
+template <typename T>
+void normalize(Vec3Span<T> v);
+
+/* out[i] = a[i] + (b[i] - a[i]) * t */
+template <typename T>
+void lerp(Vec3SpanIn<T> a, Vec3SpanIn<T> b, T t, Vec3Span<T> out);
+
+/* =========================================================================== */
+/* =============================== DEFINITIONS =============================== */
+/* =========================================================================== */
+
+template <typename T, typename F>
+void dot_prod(Vec3SpanIn<T> a, const Vec3<T, F>& b, T* out)
+{
+    for (size_t i = 0; i < a.size; ++i) {
+        out[i] = a.x[i] * b.x + a.y[i] * b.y + a.z[i] * b.z;
+    }
+}
+
+template <typename T>
+void dot_prod(Vec3SpanIn<T> a, Vec3SpanIn<T> b, T* out)
+{
+    for (size_t i = 0; i < a.size; ++i) {
+        out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+    }
+}
+
+template <typename T>
+void cross_prod(Vec3SpanIn<T> a, Vec3SpanIn<T> b, Vec3Span<T> out)
+{
+    for (size_t i = 0; i < a.size; ++i) {
+        T x = a.y[i] * b.z[i] - a.z[i] * b.y[i];
+        T y = a.z[i] * b.x[i] - a.x[i] * b.z[i];
+        T z = a.x[i] * b.y[i] - a.y[i] * b.x[i];
+        out.x[i] = x;
+        out.y[i] = y;
+        out.z[i] = z;
+    }
+}
+
+template <typename T>
+void normalize(Vec3Span<T> v)
+{
+    const T eps = static_cast<T>(Vec3<T>::EPS);
+    size_t i = 0;
+#if defined(__SSE2__)
+    // the scalar loop does not vectorize while sqrt may set errno
+    if constexpr (std::is_same<T, double>::value) {
+        const __m128d minSquared = _mm_set1_pd(eps * eps);
+        const __m128d one = _mm_set1_pd(1);
+        for (; i + 2 <= v.size; i += 2) {
+            __m128d x = _mm_loadu_pd(v.x + i);
+            __m128d y = _mm_loadu_pd(v.y + i);
+            __m128d z = _mm_loadu_pd(v.z + i);
+            __m128d sq = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)), _mm_mul_pd(z, z));
+            __m128d keep = _mm_cmplt_pd(sq, minSquared);
+            // short vectors are scaled by one instead
+            __m128d inv = _mm_div_pd(one, _mm_sqrt_pd(sq));
+            inv = _mm_or_pd(_mm_andnot_pd(keep, inv), _mm_and_pd(keep, one));
+            _mm_storeu_pd(v.x + i, _mm_mul_pd(x, inv));
+            _mm_storeu_pd(v.y + i, _mm_mul_pd(y, inv));
+            _mm_storeu_pd(v.z + i, _mm_mul_pd(z, inv));
+        }
+    } else if constexpr (std::is_same<T, float>::value) {
+        const __m128 minSquared = _mm_set1_ps(eps * eps);
+        const __m128 one = _mm_set1_ps(1);
+        for (; i + 4 <= v.size; i += 4) {
+            __m128 x = _mm_loadu_ps(v.x + i);
+            __m128 y = _mm_loadu_ps(v.y + i);
+            __m128 z = _mm_loadu_ps(v.z + i);
+            __m128 sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+            __m128 keep = _mm_cmplt_ps(sq, minSquared);
+            // short vectors are scaled by one instead
+            __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(sq));
+            inv = _mm_or_ps(_mm_andnot_ps(keep, inv), _mm_and_ps(keep, one));
+            _mm_storeu_ps(v.x + i, _mm_mul_ps(x, inv));
+            _mm_storeu_ps(v.y + i, _mm_mul_ps(y, inv));
+            _mm_storeu_ps(v.z + i, _mm_mul_ps(z, inv));
+        }
+    }
+#endif
+    for (; i < v.size; ++i) {
+        T sq = v.x[i] * v.x[i] + v.y[i] * v.y[i] + v.z[i] * v.z[i];
+        if (sq < eps * eps) {
+            continue;
+        }
+        T inv = 1 / std::sqrt(sq);
+        v.x[i] *= inv;
+        v.y[i] *= inv;
+        v.z[i] *= inv;
+    }
+}
+
+template <typename T>
+void lerp(Vec3SpanIn<T> a, Vec3SpanIn<T> b, T t, Vec3Span<T> out)
+{
+    for (size_t i = 0; i < a.size; ++i) {
+        out.x[i] = a.x[i] + (b.x[i] - a.x[i]) * t;
+        out.y[i] = a.y[i] + (b.y[i] - a.y[i]) * t;
+        out.z[i] = a.z[i] + (b.z[i] - a.z[i]) * t;
+    }
+}
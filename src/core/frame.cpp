@@ -1,4 +1,5 @@
 #include <core/frame.h>
+#include <library/profiler.h>
 
 namespace REngine {
 
@@ -24,6 +25,14 @@ Frame::Frame(Frame::Settings settings, Frame* parent, std::shared_ptr<sf::Render
     }
 }
 
+Frame::Frame(Frame::Settings settings, Graphics::SPtr graphics)
+    : _settings(std::move(settings))
+    , _parent(nullptr)
+    , _graphics(std::move(graphics))
+    , _inputController(std::make_shared<InputController>())
+    , _isRunning(true)
+{}
+
 Graphics* Frame::Gr() {
     return _graphics.get();
 }
@@ -32,6 +41,14 @@ InputController* Frame::Ic() {
     return _inputController.get();
 }
 
+FrameStats& Frame::Stats() {
+    return _stats;
+}
+
+bool Frame::IsSettled() const {
+    return true;
+}
+
 bool Frame::IsRunning() const {
     return _isRunning;
 }
@@ -49,6 +66,10 @@ bool Frame::Update(float) {
 }
 
 void Frame::PollEvents() {
+    PROFILE_SCOPE("Frame::PollEvents");
+    if (!_window) {
+        return;
+    }
     sf::Event e;
 
     while (_window->pollEvent(e)) {
@@ -0,0 +1,87 @@
+#include <core/frame_stats.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace REngine {
+
+FrameStats::FrameStats()
+    : _samples(WINDOW)
+{
+    _histogram.fill(0);
+}
+
+uint32_t FrameStats::BucketOf(float ms) {
+    if (!(ms > 0)) {
+        return 0;
+    }
+    return std::min<uint32_t>(ms / BUCKET_MS, BUCKETS - 1);
+}
+
+void FrameStats::Record(float frameMs, float updateMs, float renderMs, uint64_t allocations) {
+    Sample& slot = _samples[_next];
+    if (_count == WINDOW) {
+        // evict the oldest sample so the histogram only covers the window
+        --_histogram[BucketOf(slot.frameMs)];
+        _frameSum -= slot.frameMs;
+        _updateSum -= slot.updateMs;
+        _renderSum -= slot.renderMs;
+        _allocationSum -= slot.allocations;
+    } else {
+        ++_count;
+    }
+
+    slot = Sample{frameMs, updateMs, renderMs, allocations};
+    ++_histogram[BucketOf(frameMs)];
+    _frameSum += frameMs;
+    _updateSum += updateMs;
+    _renderSum += renderMs;
+    _allocationSum += allocations;
+
+    _next = (_next + 1) % WINDOW;
+}
+
+uint32_t FrameStats::FrameCount() const {
+    return _count;
+}
+
+float FrameStats::Fps() const {
+    return _frameSum > 0 ? 1000. * _count / _frameSum : 0;
+}
+
+float FrameStats::AverageUpdateMs() const {
+    return _count ? _updateSum / _count : 0;
+}
+
+float FrameStats::AverageRenderMs() const {
+    return _count ? _renderSum / _count : 0;
+}
+
+float FrameStats::AverageAllocations() const {
+    return _count ? static_cast<float>(_allocationSum) / _count : 0;
+}
+
+uint64_t FrameStats::LastAllocations() const {
+    return _count ? _samples[(_next + WINDOW - 1) % WINDOW].allocations : 0;
+}
+
+float FrameStats::Percentile(float p) const {
+    if (_count == 0) {
+        return 0;
+    }
+    uint32_t rank = std::max<uint32_t>(1, std::ceil(p * _count));
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < BUCKETS; ++i) {
+        seen += _histogram[i];
+        if (seen >= rank) {
+            return (i + 1) * BUCKET_MS;
+        }
+    }
+    return BUCKETS * BUCKET_MS;
+}
+
+const std::array<uint32_t, FrameStats::BUCKETS>& FrameStats::Histogram() const {
+    return _histogram;
+}
+
+} // namespace REngine
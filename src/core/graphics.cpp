@@ -1,7 +1,9 @@
 #include <core/graphics.h>
 #include <library/vec2.h>
 #include <library/ext_math.h>
+#include <library/profiler.h>
 
+#include <cmath>
 #include <iostream>
 #include <string>
 
@@ -32,13 +34,7 @@ void Graphics::DrawPoint(float x, float y)
 
 void Graphics::DrawPoint(Vec2<float> pos)
 {
-    sf::RectangleShape rectangle;
-    rectangle.setSize(sf::Vector2f(1, 1));
-    rectangle.setPosition(pos.x, pos.y);
-
-    rectangle.setFillColor(sf::Color(_fillColor.r, _fillColor.g, _fillColor.b, _fillColor.a));
-
-    _window->draw(rectangle);
+    Graphics::DrawRect(pos, Vec2<float>(1, 1));
 }
 
 void Graphics::DrawCircle(float x, float y, float radius)
@@ -47,13 +43,18 @@ void Graphics::DrawCircle(float x, float y, float radius)
 }
 void Graphics::DrawCircle(Vec2<float> pos, float radius)
 {
-    sf::CircleShape circle;
-    circle.setRadius(radius);
-    circle.setPosition(pos.x - radius, pos.y - radius);
-
-    circle.setFillColor(sf::Color(_fillColor.r, _fillColor.g, _fillColor.b, _fillColor.a));
+    // the sides of a default sf::CircleShape as a fan, shapes allocate their vertices
+    constexpr int SIDES = 30;
+    sf::Color color(_fillColor.r, _fillColor.g, _fillColor.b, _fillColor.a);
+    sf::Vertex fan[SIDES + 2];
+    fan[0] = sf::Vertex(sf::Vector2f(pos.x, pos.y), color);
+    for (int i = 0; i <= SIDES; ++i) {
+        float a = 2 * ExtMath::PI * i / SIDES - ExtMath::PI / 2;
+        fan[i + 1] = sf::Vertex(sf::Vector2f(pos.x + radius * std::cos(a), pos.y + radius * std::sin(a)), color);
+    }
 
-    _window->draw(circle);
+    _window->draw(fan, SIDES + 2, sf::TriangleFan);
+    ++_counters.drawCalls;
 }
 
 void Graphics::DrawBrokenLine(std::vector<Vec2<float>> t, Vec2<float> a, float s)
@@ -73,6 +74,7 @@ void Graphics::DrawLine(Vec2<float> v1, Vec2<float> v2)
     };
 
     _window->draw(line, 2, sf::Lines);
+    ++_counters.drawCalls;
 }
 
 void Graphics::DrawLine(float x1, float y1, float x2, float y2)
@@ -88,13 +90,17 @@ void Graphics::DrawRect(float x, float y, float W, float h)
 
 void Graphics::DrawRect(Vec2<float> pos, Vec2<float> size)
 {
-    sf::RectangleShape rectangle;
-    rectangle.setSize(sf::Vector2f(size.x, size.y));
-    rectangle.setPosition(pos.x, pos.y);
-
-    rectangle.setFillColor(sf::Color(_fillColor.r, _fillColor.g, _fillColor.b, _fillColor.a));
+    sf::Color color(_fillColor.r, _fillColor.g, _fillColor.b, _fillColor.a);
+    sf::Vertex quad[] =
+    {
+        sf::Vertex(sf::Vector2f(pos.x, pos.y), color),
+        sf::Vertex(sf::Vector2f(pos.x + size.x, pos.y), color),
+        sf::Vertex(sf::Vector2f(pos.x + size.x, pos.y + size.y), color),
+        sf::Vertex(sf::Vector2f(pos.x, pos.y + size.y), color)
+    };
 
-    _window->draw(rectangle);
+    _window->draw(quad, 4, sf::TriangleFan);
+    ++_counters.drawCalls;
 }
 
 void Graphics::DrawTexture(sf::Texture& tex, float x, float y, float W, float h)
@@ -112,6 +118,7 @@ void Graphics::DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size)
     sprite.setPosition(pos.x - size.x / 2, pos.y - size.y / 2);
     sprite.setScale(size.x / s.x, size.y / s.y);
     _window->draw(sprite);
+    ++_counters.drawCalls;
 }
 
 void Graphics::DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size, float a)
@@ -128,11 +135,62 @@ void Graphics::DrawTexture(sf::Texture& tex, Vec2<float> pos, Vec2<float> size,
     sprite.setRotation(ExtMath::ToDegrees(a));
 
     _window->draw(sprite);
+    ++_counters.drawCalls;
+}
+
+void Graphics::DrawVertices(const sf::Vertex* vertices, size_t count, sf::PrimitiveType type)
+{
+    _window->draw(vertices, count, type);
+    ++_counters.drawCalls;
+}
+
+void Graphics::DrawSprites(TextureAtlas& atlas, uint32_t page, const sf::Vertex* vertices, size_t count)
+{
+    _counters.textureUploadBytes += atlas.UploadPage(page);
+    _window->draw(vertices, count, sf::Quads, sf::RenderStates(&atlas.PageTexture(page)));
+    ++_counters.drawCalls;
+}
+
+void Graphics::DrawImage(const sf::Image& image, Vec2<float> pos, Vec2<float> size)
+{
+    sf::Vector2u s = image.getSize();
+    DrawImage(reinterpret_cast<const PackedColor*>(image.getPixelsPtr()), Vec2<uint32_t>(s.x, s.y), pos, size);
+}
+
+void Graphics::DrawImage(const PackedColor* pixels, Vec2<uint32_t> imageSize, Vec2<float> pos, Vec2<float> size)
+{
+    if (imageSize.x == 0 || imageSize.y == 0) {
+        return;
+    }
+    sf::Vector2u s(imageSize.x, imageSize.y);
+    if (!_imageTexture) {
+        _imageTexture = std::make_unique<sf::Texture>();
+    }
+    if (_imageTexture->getSize() != s) {
+        _imageTexture->create(s.x, s.y);
+    }
+    _imageTexture->update(reinterpret_cast<const sf::Uint8*>(pixels));
+    _counters.textureUploadBytes += 4ull * s.x * s.y;
+
+    DrawTexture(*_imageTexture, pos, size);
 }
 
 void Graphics::Present()
 {
+    PROFILE_SCOPE("Graphics::Present");
     _window->display();
+    SwapCounters();
+}
+
+void Graphics::SwapCounters()
+{
+    _lastFrameCounters = _counters;
+    _counters = Counters{};
+}
+
+const Graphics::Counters& Graphics::LastFrameCounters() const
+{
+    return _lastFrameCounters;
 }
 
 void Graphics::SetFillColor(float r, float g, float b, float a)
@@ -148,12 +206,21 @@ void Graphics::SetFillColor(Color col)
     _fillColor = col;
 }
 
-void Graphics::Fill()
+void Graphics::SetFillColor(PackedColor col)
 {
-    Camera::SPtr c = std::make_shared<Camera>();
+    _fillColor = col.ToColor();
+}
 
-    ApplyCamera(c);
-    DrawRect(0, 0, _window->getSize().x, _window->getSize().y);
+void Graphics::Fill()
+{
+    if (_fillColor.a >= 255) {
+        _window->clear(sf::Color(_fillColor.r, _fillColor.g, _fillColor.b));
+    } else {
+        // translucent fills blend over the frame
+        ApplyCamera(_screenCamera);
+        DrawRect(0, 0, _window->getSize().x, _window->getSize().y);
+    }
+    // drawing goes on through the camera either way
     ApplyCamera(_camera);
 }
 
@@ -172,18 +239,34 @@ void Graphics::FillText(const std::string& text, float x, float y, float size, s
     t.setCharacterSize(size);
     t.setFillColor(sf::Color(_fillColor.r, _fillColor.g, _fillColor.b, _fillColor.a));
     _window->draw(t);
+    ++_counters.drawCalls;
 }
 
-void Graphics::ApplyCamera(Camera::SPtr cam)
+sf::View Graphics::MakeView(const Camera& cam) const
 {
     sf::View view;
-    Vec2<float> p = cam->position - _windowSize / 2;
-    Vec2<float> s = _windowSize * cam->scale;
+    Vec2<float> p = cam.position - _windowSize / 2;
+    Vec2<float> s = _windowSize * cam.scale;
 
     view.reset(sf::FloatRect(p.x, p.y, s.x, s.y));
-    view.rotate(cam->angle);
+    view.rotate(cam.angle);
     view.setViewport(sf::FloatRect(0.f, 0.f, 1.f, 1.f));
+    return view;
+}
 
+void Graphics::ApplyCamera(Camera::SPtr cam)
+{
+    if (_viewCamera && _viewCamera->position == cam->position &&
+            _viewCamera->angle == cam->angle && _viewCamera->scale == cam->scale) {
+        return;
+    }
+    _viewCamera = *cam;
+    SetView(MakeView(*cam));
+    ++_counters.stateChanges;
+}
+
+void Graphics::SetView(const sf::View& view)
+{
     _window->setView(view);
 }
 
@@ -192,6 +275,11 @@ void Graphics::SetCamera(Camera::SPtr cam)
     _camera = cam;
 }
 
+Camera::SPtr Graphics::GetCamera() const
+{
+    return _camera;
+}
+
 void Graphics::SetDefaultCamera()
 {
     _camera = std::make_shared<Camera>();
@@ -0,0 +1,359 @@
+#include <core/headless_graphics.h>
+#include <library/profiler.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace REngine {
+
+HeadlessGraphics::HeadlessGraphics(Vec2<int> ws)
+    : Graphics(nullptr, ws)
+    , _pixels(4ull * ws.x * ws.y, 0)
+{
+    // same as the default view of a fresh RenderWindow
+    SetView(sf::View(sf::FloatRect(0, 0, ws.x, ws.y)));
+    Clear();
+}
+
+void HeadlessGraphics::SetView(const sf::View& view)
+{
+    // normalized device coordinates to pixels, y axis is flipped
+    float w = _windowSize.x;
+    float h = _windowSize.y;
+    sf::Transform viewport(
+        w / 2, 0, w / 2,
+        0, -h / 2, h / 2,
+        0, 0, 1);
+    _toPixel = viewport * view.getTransform();
+    _fromPixel = _toPixel.getInverse();
+}
+
+sf::Color HeadlessGraphics::FillColor() const
+{
+    return sf::Color(_fillColor.r, _fillColor.g, _fillColor.b, _fillColor.a);
+}
+
+void HeadlessGraphics::Blend(int x, int y, sf::Color c)
+{
+    if (x < 0 || y < 0 || x >= _windowSize.x || y >= _windowSize.y) {
+        return;
+    }
+    sf::Uint8* p = &_pixels[4 * (static_cast<size_t>(y) * _windowSize.x + x)];
+    if (c.a == 255) {
+        p[0] = c.r;
+        p[1] = c.g;
+        p[2] = c.b;
+        p[3] = 255;
+        return;
+    }
+    uint32_t a = c.a;
+    p[0] = (c.r * a + p[0] * (255 - a)) / 255;
+    p[1] = (c.g * a + p[1] * (255 - a)) / 255;
+    p[2] = (c.b * a + p[2] * (255 - a)) / 255;
+    p[3] = std::min<uint32_t>(255, a + p[3] * (255 - a) / 255);
+}
+
+void HeadlessGraphics::FillConvex(const sf::Vector2f* corners, size_t n, sf::Color c)
+{
+    float minX = corners[0].x, maxX = corners[0].x;
+    float minY = corners[0].y, maxY = corners[0].y;
+    float area = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const sf::Vector2f& a = corners[i];
+        const sf::Vector2f& b = corners[(i + 1) % n];
+        minX = std::min(minX, a.x);
+        maxX = std::max(maxX, a.x);
+        minY = std::min(minY, a.y);
+        maxY = std::max(maxY, a.y);
+        area += a.x * b.y - b.x * a.y;
+    }
+    if (area == 0) {
+        return;
+    }
+    float orientation = area > 0 ? 1 : -1;
+
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int x1 = std::min(_windowSize.x - 1, static_cast<int>(std::ceil(maxX)));
+    int y1 = std::min(_windowSize.y - 1, static_cast<int>(std::ceil(maxY)));
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            // sample pixel centers, inside when left of every edge
+            float px = x + 0.5f;
+            float py = y + 0.5f;
+            bool inside = true;
+            for (size_t i = 0; i < n && inside; ++i) {
+                const sf::Vector2f& a = corners[i];
+                const sf::Vector2f& b = corners[(i + 1) % n];
+                inside = orientation * ((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x)) >= 0;
+            }
+            if (inside) {
+                Blend(x, y, c);
+            }
+        }
+    }
+}
+
+void HeadlessGraphics::FillLine(sf::Vector2f a, sf::Vector2f b, sf::Color c)
+{
+    float steps = std::max(std::abs(b.x - a.x), std::abs(b.y - a.y));
+    int n = std::max(1, static_cast<int>(std::ceil(steps)));
+    for (int i = 0; i <= n; ++i) {
+        float t = static_cast<float>(i) / n;
+        Blend(std::floor(a.x + (b.x - a.x) * t), std::floor(a.y + (b.y - a.y) * t), c);
+    }
+}
+
+void HeadlessGraphics::DrawPoint(Vec2<float> pos)
+{
+    sf::Vector2f p = _toPixel.transformPoint(pos.x, pos.y);
+    Blend(std::floor(p.x), std::floor(p.y), FillColor());
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawCircle(Vec2<float> pos, float radius)
+{
+    sf::Vector2f c = _toPixel.transformPoint(pos.x, pos.y);
+    sf::Vector2f e = _toPixel.transformPoint(pos.x + radius, pos.y);
+    float r = std::hypot(e.x - c.x, e.y - c.y);
+
+    int y0 = std::max(0, static_cast<int>(std::floor(c.y - r)));
+    int y1 = std::min(_windowSize.y - 1, static_cast<int>(std::ceil(c.y + r)));
+    for (int y = y0; y <= y1; ++y) {
+        float dy = y + 0.5f - c.y;
+        if (dy * dy > r * r) {
+            continue;
+        }
+        float dx = std::sqrt(r * r - dy * dy);
+        int x0 = std::max(0, static_cast<int>(std::ceil(c.x - dx - 0.5f)));
+        int x1 = std::min(_windowSize.x - 1, static_cast<int>(std::floor(c.x + dx - 0.5f)));
+        for (int x = x0; x <= x1; ++x) {
+            Blend(x, y, FillColor());
+        }
+    }
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawLine(Vec2<float> v1, Vec2<float> v2)
+{
+    FillLine(_toPixel.transformPoint(v1.x, v1.y), _toPixel.transformPoint(v2.x, v2.y), FillColor());
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawRect(Vec2<float> pos, Vec2<float> size)
+{
+    sf::Vector2f corners[4] = {
+        _toPixel.transformPoint(pos.x, pos.y),
+        _toPixel.transformPoint(pos.x + size.x, pos.y),
+        _toPixel.transformPoint(pos.x + size.x, pos.y + size.y),
+        _toPixel.transformPoint(pos.x, pos.y + size.y),
+    };
+    FillConvex(corners, 4, FillColor());
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawTexture(sf::Texture&, Vec2<float>, Vec2<float>)
+{
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawTexture(sf::Texture&, Vec2<float>, Vec2<float>, float)
+{
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawImage(const PackedColor* pixels, Vec2<uint32_t> s, Vec2<float> pos, Vec2<float> size)
+{
+    PROFILE_SCOPE("HeadlessGraphics::DrawImage");
+    if (s.x == 0 || s.y == 0 || size.x == 0 || size.y == 0) {
+        return;
+    }
+    Vec2<float> topLeft = pos - size * 0.5f;
+
+    sf::FloatRect bounds = _toPixel.transformRect(sf::FloatRect(topLeft.x, topLeft.y, size.x, size.y));
+    int x0 = std::max(0, static_cast<int>(std::floor(bounds.left)));
+    int y0 = std::max(0, static_cast<int>(std::floor(bounds.top)));
+    int x1 = std::min(_windowSize.x, static_cast<int>(std::ceil(bounds.left + bounds.width)));
+    int y1 = std::min(_windowSize.y, static_cast<int>(std::ceil(bounds.top + bounds.height)));
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            // nearest neighbour, as the window backend with a non-smooth texture
+            sf::Vector2f q = _fromPixel.transformPoint(x + 0.5f, y + 0.5f);
+            float u = (q.x - topLeft.x) / size.x;
+            float v = (q.y - topLeft.y) / size.y;
+            if (u < 0 || v < 0 || u >= 1 || v >= 1) {
+                continue;
+            }
+            PackedColor texel = pixels[static_cast<size_t>(v * s.y) * s.x + static_cast<size_t>(u * s.x)];
+            Blend(x, y, sf::Color(texel.r, texel.g, texel.b, texel.a));
+        }
+    }
+    _counters.textureUploadBytes += 4ull * s.x * s.y;
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawVertices(const sf::Vertex* vertices, size_t count, sf::PrimitiveType type)
+{
+    auto pixel = [&](size_t i) {
+        return _toPixel.transformPoint(vertices[i].position);
+    };
+    auto triangle = [&](size_t a, size_t b, size_t c) {
+        sf::Vector2f corners[3] = {pixel(a), pixel(b), pixel(c)};
+        FillConvex(corners, 3, vertices[a].color);
+    };
+
+    switch (type) {
+    case sf::Points:
+        for (size_t i = 0; i < count; ++i) {
+            sf::Vector2f p = pixel(i);
+            Blend(std::floor(p.x), std::floor(p.y), vertices[i].color);
+        }
+        break;
+    case sf::Lines:
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            FillLine(pixel(i), pixel(i + 1), vertices[i].color);
+        }
+        break;
+    case sf::LineStrip:
+        for (size_t i = 0; i + 1 < count; ++i) {
+            FillLine(pixel(i), pixel(i + 1), vertices[i].color);
+        }
+        break;
+    case sf::Triangles:
+        for (size_t i = 0; i + 2 < count; i += 3) {
+            triangle(i, i + 1, i + 2);
+        }
+        break;
+    case sf::TriangleStrip:
+        for (size_t i = 0; i + 2 < count; ++i) {
+            triangle(i, i + 1, i + 2);
+        }
+        break;
+    case sf::TriangleFan:
+        for (size_t i = 1; i + 1 < count; ++i) {
+            triangle(0, i, i + 1);
+        }
+        break;
+    case sf::Quads:
+        for (size_t i = 0; i + 3 < count; i += 4) {
+            sf::Vector2f corners[4] = {pixel(i), pixel(i + 1), pixel(i + 2), pixel(i + 3)};
+            FillConvex(corners, 4, vertices[i].color);
+        }
+        break;
+    }
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::DrawSprites(TextureAtlas& atlas, uint32_t page, const sf::Vertex* vertices, size_t count)
+{
+    PROFILE_SCOPE("HeadlessGraphics::DrawSprites");
+    const PackedColor* pixels = atlas.PagePixels(page);
+    const int pageSize = atlas.PageSize();
+    for (size_t i = 0; i + 3 < count; i += 4) {
+        const sf::Vertex* quad = vertices + i;
+        // quads are parallelograms in pixels too, spanned by the edges from the first corner
+        sf::Vector2f p0 = _toPixel.transformPoint(quad[0].position);
+        sf::Vector2f e1 = _toPixel.transformPoint(quad[1].position) - p0;
+        sf::Vector2f e2 = _toPixel.transformPoint(quad[3].position) - p0;
+        float det = e1.x * e2.y - e1.y * e2.x;
+        if (det == 0) {
+            continue;
+        }
+        sf::Vector2f t0 = quad[0].texCoords;
+        sf::Vector2f t1 = quad[1].texCoords - t0;
+        sf::Vector2f t2 = quad[3].texCoords - t0;
+        sf::Color tint = quad[0].color;
+
+        float minX = std::min({p0.x, p0.x + e1.x, p0.x + e2.x, p0.x + e1.x + e2.x});
+        float maxX = std::max({p0.x, p0.x + e1.x, p0.x + e2.x, p0.x + e1.x + e2.x});
+        float minY = std::min({p0.y, p0.y + e1.y, p0.y + e2.y, p0.y + e1.y + e2.y});
+        float maxY = std::max({p0.y, p0.y + e1.y, p0.y + e2.y, p0.y + e1.y + e2.y});
+        int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+        int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+        int x1 = std::min(_windowSize.x - 1, static_cast<int>(std::ceil(maxX)));
+        int y1 = std::min(_windowSize.y - 1, static_cast<int>(std::ceil(maxY)));
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                // pixel center in the coordinates of the edges, nearest texel as a non-smooth texture
+                float dx = x + 0.5f - p0.x;
+                float dy = y + 0.5f - p0.y;
+                float u = (dx * e2.y - dy * e2.x) / det;
+                float v = (e1.x * dy - e1.y * dx) / det;
+                if (u < 0 || v < 0 || u >= 1 || v >= 1) {
+                    continue;
+                }
+                int tx = std::clamp(static_cast<int>(t0.x + u * t1.x + v * t2.x), 0, pageSize - 1);
+                int ty = std::clamp(static_cast<int>(t0.y + u * t1.y + v * t2.y), 0, pageSize - 1);
+                PackedColor texel = pixels[static_cast<size_t>(ty) * pageSize + tx];
+                Blend(x, y, sf::Color(texel.r * tint.r / 255, texel.g * tint.g / 255,
+                        texel.b * tint.b / 255, texel.a * tint.a / 255));
+            }
+        }
+    }
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::Fill()
+{
+    sf::Color c = FillColor();
+    if (c.a == 255) {
+        for (size_t i = 0; i < _pixels.size(); i += 4) {
+            _pixels[i] = c.r;
+            _pixels[i + 1] = c.g;
+            _pixels[i + 2] = c.b;
+            _pixels[i + 3] = 255;
+        }
+    } else {
+        for (int y = 0; y < _windowSize.y; ++y) {
+            for (int x = 0; x < _windowSize.x; ++x) {
+                Blend(x, y, c);
+            }
+        }
+        ++_counters.drawCalls;
+    }
+    // drawing goes on through the camera, as after Graphics::Fill
+    ApplyCamera(_camera);
+}
+
+void HeadlessGraphics::Clear()
+{
+    for (size_t i = 0; i < _pixels.size(); i += 4) {
+        _pixels[i] = _pixels[i + 1] = _pixels[i + 2] = 0;
+        _pixels[i + 3] = 255;
+    }
+}
+
+void HeadlessGraphics::FillText(const std::string&, float, float, float, sf::Font&)
+{
+    ++_counters.drawCalls;
+}
+
+void HeadlessGraphics::Present()
+{
+    ++_presentedFrames;
+    SwapCounters();
+}
+
+const sf::Uint8* HeadlessGraphics::Pixels() const
+{
+    return _pixels.data();
+}
+
+Vec2<int> HeadlessGraphics::Size() const
+{
+    return _windowSize;
+}
+
+uint32_t HeadlessGraphics::PresentedFrames() const
+{
+    return _presentedFrames;
+}
+
+bool HeadlessGraphics::SaveToFile(const std::string& path) const
+{
+    sf::Image image;
+    image.create(_windowSize.x, _windowSize.y, _pixels.data());
+    return image.saveToFile(path);
+}
+
+} // namespace REngine
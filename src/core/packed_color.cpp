@@ -0,0 +1,168 @@
+#include <core/packed_color.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace REngine {
+
+namespace {
+
+// rounds to nearest like cvtps, so the scalar tail matches the vector body
+uint8_t Saturate(float v) {
+    if (!(v > 0)) {
+        return 0;
+    }
+    return v >= 255 ? 255 : static_cast<uint8_t>(std::nearbyint(v));
+}
+
+uint8_t Saturate(int v) {
+    return std::max(0, std::min(255, v));
+}
+
+#if defined(__SSE2__)
+
+// 4 pixels <-> 4 float vectors, one pixel per vector, channels in lanes
+struct Pixels4 {
+    __m128 p[4];
+};
+
+Pixels4 Unpack(const PackedColor* src) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    return Pixels4{{
+        _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)),
+        _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)),
+        _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)),
+        _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)),
+    }};
+}
+
+// Clamped to [0, 255] before the conversion, which gives INT_MIN for values beyond int
+// and infinities. max takes its second operand for NaN, so NaN becomes 0 like in Saturate
+__m128i Round(__m128 v) {
+    return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255)));
+}
+
+void Pack(const Pixels4& pixels, PackedColor* dst) {
+    __m128i lo = _mm_packs_epi32(Round(pixels.p[0]), Round(pixels.p[1]));
+    __m128i hi = _mm_packs_epi32(Round(pixels.p[2]), Round(pixels.p[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(lo, hi));
+}
+
+template <int I>
+__m128 Broadcast(__m128 v) {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(I, I, I, I));
+}
+
+#endif
+
+} // namespace
+
+Color PackedColor::ToColor() const
+{
+    return Color(r, g, b, a);
+}
+
+PackedColor PackedColor::operator+(PackedColor right) const
+{
+    return PackedColor(Saturate(r + right.r), Saturate(g + right.g), Saturate(b + right.b), a);
+}
+
+PackedColor PackedColor::operator-(PackedColor right) const
+{
+    return PackedColor(Saturate(r - right.r), Saturate(g - right.g), Saturate(b - right.b), a);
+}
+
+PackedColor PackedColor::operator*(float right) const
+{
+    return PackedColor(Saturate(r * right), Saturate(g * right), Saturate(b * right), a);
+}
+
+void ScaleColors(const PackedColor* src, const float* factors, PackedColor* dst, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    // alpha lane is multiplied by one
+    const __m128 rgbMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 alphaOne = _mm_setr_ps(0, 0, 0, 1);
+    for (; i + 4 <= count; i += 4) {
+        Pixels4 pixels = Unpack(src + i);
+        __m128 f = _mm_loadu_ps(factors + i);
+        __m128 f4[4] = {Broadcast<0>(f), Broadcast<1>(f), Broadcast<2>(f), Broadcast<3>(f)};
+        for (int k = 0; k < 4; ++k) {
+            __m128 m = _mm_or_ps(_mm_and_ps(f4[k], rgbMask), alphaOne);
+            pixels.p[k] = _mm_mul_ps(pixels.p[k], m);
+        }
+        Pack(pixels, dst + i);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i] * factors[i];
+    }
+}
+
+void AddColors(const PackedColor* l, const PackedColor* r, PackedColor* dst, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+        __m128i sum = _mm_adds_epu8(a, b);
+        __m128i result = _mm_or_si128(_mm_andnot_si128(alphaMask, sum), _mm_and_si128(alphaMask, a));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = l[i] + r[i];
+    }
+}
+
+void LerpColors(const PackedColor* l, const PackedColor* r, const float* t, PackedColor* dst, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        Pixels4 a = Unpack(l + i);
+        Pixels4 b = Unpack(r + i);
+        __m128 tt = _mm_loadu_ps(t + i);
+        __m128 t4[4] = {Broadcast<0>(tt), Broadcast<1>(tt), Broadcast<2>(tt), Broadcast<3>(tt)};
+        for (int k = 0; k < 4; ++k) {
+            a.p[k] = _mm_add_ps(a.p[k], _mm_mul_ps(_mm_sub_ps(b.p[k], a.p[k]), t4[k]));
+        }
+        Pack(a, dst + i);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = PackedColor(
+            Saturate(l[i].r + (r[i].r - l[i].r) * t[i]),
+            Saturate(l[i].g + (r[i].g - l[i].g) * t[i]),
+            Saturate(l[i].b + (r[i].b - l[i].b) * t[i]),
+            Saturate(l[i].a + (r[i].a - l[i].a) * t[i]));
+    }
+}
+
+void PackColors(const float* r, const float* g, const float* b, PackedColor* dst, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        // planes to pixels is a 4x4 transpose
+        Pixels4 pixels{{_mm_loadu_ps(r + i), _mm_loadu_ps(g + i), _mm_loadu_ps(b + i), _mm_set1_ps(255)}};
+        _MM_TRANSPOSE4_PS(pixels.p[0], pixels.p[1], pixels.p[2], pixels.p[3]);
+        Pack(pixels, dst + i);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = PackedColor(Saturate(r[i]), Saturate(g[i]), Saturate(b[i]));
+    }
+}
+
+} // namespace REngine
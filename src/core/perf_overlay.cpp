@@ -0,0 +1,137 @@
+#include <core/perf_overlay.h>
+#include <library/alloc_tracker.h>
+#include <library/profiler.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace REngine {
+
+namespace {
+
+constexpr uint32_t HISTOGRAM_BARS = 64;
+constexpr float PADDING = 6;
+
+sf::Color BarColor(float ms) {
+    if (ms < 1000.f / 60) {
+        return sf::Color(90, 220, 90);
+    }
+    if (ms < 1000.f / 30) {
+        return sf::Color(230, 200, 60);
+    }
+    return sf::Color(230, 70, 60);
+}
+
+} // namespace
+
+PerfOverlay::PerfOverlay()
+    : PerfOverlay(Settings{})
+{}
+
+PerfOverlay::PerfOverlay(Settings settings)
+    : _settings(std::move(settings))
+    , _vertices(HISTOGRAM_BARS * 6)
+    , _screenCamera(std::make_shared<Camera>())
+{
+    _fontLoaded = _font.loadFromFile(_settings.fontPath);
+    if (!_fontLoaded) {
+        std::cerr << "PerfOverlay: no font at " << _settings.fontPath << ", text disabled" << std::endl;
+    }
+    _text.reserve(512);
+}
+
+void PerfOverlay::Toggle() {
+    _visible = !_visible;
+}
+
+bool PerfOverlay::IsVisible() const {
+    return _visible;
+}
+
+void PerfOverlay::SetDetails(std::string details) {
+    _details = std::move(details);
+}
+
+void PerfOverlay::BuildHistogram(const FrameStats& stats, Vec2f origin) {
+    const auto& buckets = stats.Histogram();
+    const float rangeMs = std::clamp<float>(
+            _settings.histogramRangeMs, FrameStats::BUCKET_MS, FrameStats::BUCKETS * FrameStats::BUCKET_MS);
+    const float barMs = rangeMs / HISTOGRAM_BARS;
+
+    // bars need not align with the buckets, a bucket goes to the bar its start falls in
+    std::array<uint32_t, HISTOGRAM_BARS> bars{};
+    for (uint32_t i = 0; i < FrameStats::BUCKETS; ++i) {
+        uint32_t bar = static_cast<uint32_t>(i * FrameStats::BUCKET_MS / barMs);
+        bars[std::min(bar, HISTOGRAM_BARS - 1)] += buckets[i];
+    }
+    uint32_t maxCount = std::max<uint32_t>(1, *std::max_element(bars.begin(), bars.end()));
+
+    const float barWidth = (_settings.width - 2 * PADDING) / HISTOGRAM_BARS;
+    for (uint32_t i = 0; i < HISTOGRAM_BARS; ++i) {
+        float h = _settings.histogramHeight * bars[i] / maxCount;
+        float x0 = origin.x + i * barWidth;
+        float x1 = x0 + barWidth - 1;
+        float y0 = origin.y + _settings.histogramHeight - h;
+        float y1 = origin.y + _settings.histogramHeight;
+        sf::Color color = BarColor(i * barMs);
+
+        sf::Vertex* quad = &_vertices[i * 6];
+        quad[0] = sf::Vertex(sf::Vector2f(x0, y0), color);
+        quad[1] = sf::Vertex(sf::Vector2f(x1, y0), color);
+        quad[2] = sf::Vertex(sf::Vector2f(x1, y1), color);
+        quad[3] = sf::Vertex(sf::Vector2f(x0, y0), color);
+        quad[4] = sf::Vertex(sf::Vector2f(x1, y1), color);
+        quad[5] = sf::Vertex(sf::Vector2f(x0, y1), color);
+    }
+}
+
+void PerfOverlay::Render(Graphics* gr, const FrameStats& stats, Vec2i screenSize) {
+    if (!_visible) {
+        return;
+    }
+    PROFILE_SCOPE("PerfOverlay::Render");
+
+    const Graphics::Counters& counters = gr->LastFrameCounters();
+    char line[256];
+    std::snprintf(line, sizeof(line),
+            "FPS %.1f\n"
+            "frame p50 %.2f  p95 %.2f  p99 %.2f ms\n"
+            "update %.2f ms  render %.2f ms\n"
+            "draw calls %u  state changes %u  upload %.1f KiB\n",
+            stats.Fps(),
+            stats.Percentile(0.5), stats.Percentile(0.95), stats.Percentile(0.99),
+            stats.AverageUpdateMs(), stats.AverageRenderMs(),
+            counters.drawCalls, counters.stateChanges, counters.textureUploadBytes / 1024.);
+    _text.assign(line);
+    if (AllocTracker::Enabled()) {
+        std::snprintf(line, sizeof(line), "allocations %llu  avg %.1f per frame\n",
+                static_cast<unsigned long long>(stats.LastAllocations()), stats.AverageAllocations());
+        _text += line;
+    }
+    _text += _details;
+
+    uint32_t lines = std::count(_text.begin(), _text.end(), '\n') + 1;
+    Vec2f origin = _settings.position;
+    float textHeight = lines * _settings.lineHeight;
+    Vec2f size(_settings.width, textHeight + _settings.histogramHeight + 3 * PADDING);
+
+    Camera::SPtr worldCamera = gr->GetCamera();
+    _screenCamera->position = Vec2f(screenSize) * 0.5f;
+    gr->ApplyCamera(_screenCamera);
+
+    gr->SetFillColor(Color(0, 0, 0, 170));
+    gr->DrawRect(origin, size);
+
+    BuildHistogram(stats, origin + Vec2f(PADDING, 2 * PADDING + textHeight));
+    gr->DrawVertices(_vertices.data(), _vertices.size(), sf::Triangles);
+
+    if (_fontLoaded) {
+        gr->SetFillColor(Color::WHITE);
+        gr->FillText(_text, origin.x + PADDING, origin.y + PADDING, _settings.textSize, _font);
+    }
+
+    gr->ApplyCamera(worldCamera);
+}
+
+} // namespace REngine
@@ -0,0 +1,77 @@
+#include <core/sprite_batch.h>
+
+#include <cmath>
+
+namespace REngine {
+
+SpriteBatch::SpriteBatch(TextureAtlas& atlas)
+    : _atlas(atlas)
+{
+}
+
+void SpriteBatch::Draw(const TextureAtlas::Region& region, Vec2<float> pos, Vec2<float> size)
+{
+    float left = pos.x - size.x / 2;
+    float top = pos.y - size.y / 2;
+    const sf::Vector2f corners[4] = {
+        sf::Vector2f(left, top),
+        sf::Vector2f(left + size.x, top),
+        sf::Vector2f(left + size.x, top + size.y),
+        sf::Vector2f(left, top + size.y),
+    };
+    AddQuad(region, corners);
+}
+
+void SpriteBatch::Draw(const TextureAtlas::Region& region, Vec2<float> pos, Vec2<float> size, float a)
+{
+    // half diagonals, rotated clockwise on screen as sf::Transformable::setRotation
+    float c = std::cos(a);
+    float s = std::sin(a);
+    sf::Vector2f u(size.x / 2 * c, size.x / 2 * s);
+    sf::Vector2f v(-size.y / 2 * s, size.y / 2 * c);
+    sf::Vector2f center(pos.x, pos.y);
+    const sf::Vector2f corners[4] = {
+        center - u - v,
+        center + u - v,
+        center + u + v,
+        center - u + v,
+    };
+    AddQuad(region, corners);
+}
+
+void SpriteBatch::Flush(Graphics& graphics)
+{
+    for (uint32_t page = 0; page < _pages.size(); ++page) {
+        std::vector<sf::Vertex>& vertices = _pages[page];
+        if (!vertices.empty()) {
+            graphics.DrawSprites(_atlas, page, vertices.data(), vertices.size());
+            vertices.clear();
+        }
+    }
+    _size = 0;
+}
+
+size_t SpriteBatch::Size() const
+{
+    return _size;
+}
+
+void SpriteBatch::AddQuad(const TextureAtlas::Region& region, const sf::Vector2f (&corners)[4])
+{
+    if (_pages.size() <= region.page) {
+        _pages.resize(region.page + 1);
+    }
+    float left = region.position.x;
+    float top = region.position.y;
+    float right = left + region.size.x;
+    float bottom = top + region.size.y;
+
+    std::vector<sf::Vertex>& vertices = _pages[region.page];
+    vertices.emplace_back(corners[0], sf::Vector2f(left, top));
+    vertices.emplace_back(corners[1], sf::Vector2f(right, top));
+    vertices.emplace_back(corners[2], sf::Vector2f(right, bottom));
+    vertices.emplace_back(corners[3], sf::Vector2f(left, bottom));
+    ++_size;
+}
+
+} // namespace REngine
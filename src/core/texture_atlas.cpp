@@ -0,0 +1,153 @@
+#include <core/texture_atlas.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace REngine {
+
+TextureAtlas::TextureAtlas(uint32_t pageSize)
+    : _pageSize(pageSize)
+{
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::Add(const PackedColor* pixels, Vec2<uint32_t> size)
+{
+    uint32_t w = size.x + 2 * PADDING;
+    uint32_t h = size.y + 2 * PADDING;
+    if (w > _pageSize || h > _pageSize) {
+        return std::nullopt;
+    }
+
+    size_t segment = 0;
+    std::optional<Vec2<uint32_t>> position;
+    uint32_t page = 0;
+    for (; page < _pages.size(); ++page) {
+        position = Fit(_pages[page], w, h, segment);
+        if (position) {
+            break;
+        }
+    }
+    if (!position) {
+        position = Fit(OpenPage(), w, h, segment);
+    }
+    Page& target = _pages[page];
+    Place(target, segment, *position, w, h);
+
+    Vec2<uint32_t> origin(position->x + PADDING, position->y + PADDING);
+    for (uint32_t y = 0; y < size.y; ++y) {
+        std::memcpy(&target.pixels[static_cast<size_t>(origin.y + y) * _pageSize + origin.x],
+                pixels + static_cast<size_t>(y) * size.x, size.x * sizeof(PackedColor));
+    }
+    target.dirty = true;
+    return Region{page, origin, size};
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::Add(const sf::Image& image)
+{
+    sf::Vector2u s = image.getSize();
+    return Add(reinterpret_cast<const PackedColor*>(image.getPixelsPtr()), Vec2<uint32_t>(s.x, s.y));
+}
+
+uint32_t TextureAtlas::PageCount() const
+{
+    return _pages.size();
+}
+
+uint32_t TextureAtlas::PageSize() const
+{
+    return _pageSize;
+}
+
+const PackedColor* TextureAtlas::PagePixels(uint32_t page) const
+{
+    return _pages[page].pixels.data();
+}
+
+uint64_t TextureAtlas::UploadPage(uint32_t page)
+{
+    Page& p = _pages[page];
+    if (!p.dirty) {
+        return 0;
+    }
+    if (!p.texture) {
+        p.texture = std::make_unique<sf::Texture>();
+        p.texture->create(_pageSize, _pageSize);
+    }
+    p.texture->update(reinterpret_cast<const sf::Uint8*>(p.pixels.data()));
+    p.dirty = false;
+    return 4ull * _pageSize * _pageSize;
+}
+
+const sf::Texture& TextureAtlas::PageTexture(uint32_t page) const
+{
+    return *_pages[page].texture;
+}
+
+std::optional<Vec2<uint32_t>> TextureAtlas::Fit(const Page& page, uint32_t w, uint32_t h, size_t& segment) const
+{
+    std::optional<Vec2<uint32_t>> best;
+    uint32_t bestWidth = 0;
+    const std::vector<Segment>& skyline = page.skyline;
+    for (size_t i = 0; i < skyline.size(); ++i) {
+        uint32_t x = skyline[i].x;
+        if (x + w > _pageSize) {
+            break;
+        }
+        // the rectangle rests on the highest segment below it
+        uint32_t y = 0;
+        uint32_t covered = 0;
+        for (size_t j = i; covered < w; ++j) {
+            y = std::max(y, skyline[j].y);
+            covered += skyline[j].width;
+        }
+        if (y + h > _pageSize) {
+            continue;
+        }
+        if (!best || y < best->y || (y == best->y && skyline[i].width < bestWidth)) {
+            best = Vec2<uint32_t>(x, y);
+            bestWidth = skyline[i].width;
+            segment = i;
+        }
+    }
+    return best;
+}
+
+void TextureAtlas::Place(Page& page, size_t segment, Vec2<uint32_t> position, uint32_t w, uint32_t h)
+{
+    std::vector<Segment>& skyline = page.skyline;
+    skyline.insert(skyline.begin() + segment, Segment{position.x, position.y + h, w});
+
+    // cut the segments now under the rectangle
+    uint32_t right = position.x + w;
+    size_t next = segment + 1;
+    while (next < skyline.size() && skyline[next].x < right) {
+        uint32_t overlap = right - skyline[next].x;
+        if (skyline[next].width <= overlap) {
+            skyline.erase(skyline.begin() + next);
+            continue;
+        }
+        skyline[next].x += overlap;
+        skyline[next].width -= overlap;
+        break;
+    }
+
+    // neighbours at the same height become one segment
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+}
+
+TextureAtlas::Page& TextureAtlas::OpenPage()
+{
+    Page& page = _pages.emplace_back();
+    page.skyline.push_back(Segment{0, 0, _pageSize});
+    page.pixels.assign(static_cast<size_t>(_pageSize) * _pageSize, PackedColor(0, 0, 0, 0));
+    return page;
+}
+
+} // namespace REngine
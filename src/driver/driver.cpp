@@ -1,7 +1,11 @@
 #include <driver/driver.h>
+#include <library/alloc_tracker.h>
+#include <library/profiler.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <ctime>
 #include <iostream>
 #include <thread>
@@ -27,6 +31,7 @@ SingleFrameDriver::SingleFrameDriver(Frame::UPtr&& frame, Settings settings)
 {}
 
 void SingleFrameDriver::Initialize() {
+    PROFILE_SCOPE("SingleFrameDriver::Initialize");
     _frame->Initialize();
 }
 
@@ -36,6 +41,7 @@ void SingleFrameDriver::Run() {
     Timestamp startTime = SystemClock::now();
 
     while (true) {
+        PROFILE_SCOPE("SingleFrameDriver::Run");
         Timestamp currentTime = SystemClock::now();
         int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(currentTime - startTime).count();
         float elapsedMs = 0.001 * elapsedUs;
@@ -44,12 +50,121 @@ void SingleFrameDriver::Run() {
             elapsedMs = _settings.minimumUpdateDelayMs;
         }
         startTime = SystemClock::now();
+        const AllocTracker::Counters frameStart = AllocTracker::Totals();
 
-        if (!_frame->Update(elapsedMs)) {
-            break;
+        {
+            PROFILE_SCOPE("Frame::Update");
+            if (!_frame->Update(elapsedMs)) {
+                break;
+            }
         }
-        _frame->Render();
+        Timestamp updatedTime = SystemClock::now();
+        {
+            PROFILE_SCOPE("Frame::Render");
+            _frame->Render();
+        }
+        Timestamp renderedTime = SystemClock::now();
+
+        auto toMs = [](auto duration) {
+            return 0.001f * std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        };
+        const uint64_t allocations = (AllocTracker::Totals() - frameStart).allocations;
+        _frame->Stats().Record(elapsedMs, toMs(updatedTime - startTime), toMs(renderedTime - updatedTime), allocations);
+    }
+}
+
+
+
+HeadlessDriver::HeadlessDriver(Frame::UPtr&& frame, Settings settings)
+    : _frame(std::forward<Frame::UPtr>(frame))
+    , _settings(settings)
+{}
+
+void HeadlessDriver::Initialize() {
+    PROFILE_SCOPE("HeadlessDriver::Initialize");
+    _frame->Initialize();
+}
+
+void HeadlessDriver::Run() {
+    using SteadyClock = std::chrono::steady_clock;
+    auto toMs = [](auto duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(_settings.frames);
+    _report = Report{};
+
+    bool steady = false;
+    auto running = [&](uint32_t i) {
+        return _settings.framesAfterSettling ? _report.steadyFrames < _settings.frames : i < _settings.frames;
+    };
+    for (uint32_t i = 0; running(i); ++i) {
+        PROFILE_SCOPE("HeadlessDriver::Run");
+        if (!steady && i >= _settings.warmupFrames && _frame->IsSettled()) {
+            steady = true;
+            if (AllocTracker::Enabled()) {
+                // steady frames should not allocate at all, every allocation is worth a stack
+                AllocTracker::StartSampling(1);
+            }
+        }
+        const AllocTracker::Counters frameStart = AllocTracker::Totals();
+        auto startTime = SteadyClock::now();
+        {
+            PROFILE_SCOPE("Frame::Update");
+            if (!_frame->Update(_settings.frameDeltaMs)) {
+                break;
+            }
+        }
+        auto updatedTime = SteadyClock::now();
+        {
+            PROFILE_SCOPE("Frame::Render");
+            _frame->Render();
+        }
+        auto renderedTime = SteadyClock::now();
+
+        double updateMs = toMs(updatedTime - startTime);
+        double renderMs = toMs(renderedTime - updatedTime);
+        const uint64_t allocations = (AllocTracker::Totals() - frameStart).allocations;
+        _frame->Stats().Record(updateMs + renderMs, updateMs, renderMs, allocations);
+
+        _report.allocations += allocations;
+        if (steady) {
+            ++_report.steadyFrames;
+            _report.steadyAllocations += allocations;
+            _report.allocatingSteadyFrames += allocations > 0;
+        }
+
+        frameTimes.push_back(updateMs + renderMs);
+        _report.averageUpdateMs += updateMs;
+        _report.averageRenderMs += renderMs;
     }
+
+    AllocTracker::StopSampling();
+
+    _report.frames = frameTimes.size();
+    if (frameTimes.empty()) {
+        return;
+    }
+    for (double t : frameTimes) {
+        _report.totalMs += t;
+    }
+    _report.averageUpdateMs /= _report.frames;
+    _report.averageRenderMs /= _report.frames;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto percentile = [&](double p) {
+        size_t rank = std::ceil(p * frameTimes.size());
+        return frameTimes[std::clamp<size_t>(rank, 1, frameTimes.size()) - 1];
+    };
+    _report.p50Ms = percentile(0.5);
+    _report.p95Ms = percentile(0.95);
+    _report.p99Ms = percentile(0.99);
+    _report.maxMs = frameTimes.back();
+}
+
+const HeadlessDriver::Report& HeadlessDriver::GetReport() const {
+    return _report;
 }
 
-} // namespace REngine
\ No newline at end of file
+} // namespace REngine
@@ -0,0 +1,204 @@
+#include <library/alloc_tracker.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define RENGINE_HAS_BACKTRACE
+#endif
+
+namespace AllocTracker {
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> frees{0};
+std::atomic<uint64_t> bytes{0};
+
+std::atomic<uint32_t> samplePeriod{0};
+std::atomic<uint64_t> sampleCountdown{0};
+std::atomic<uint64_t> sampleHead{0};
+Sample samples[SAMPLE_CAPACITY];
+
+// backtrace may allocate itself, those allocations are counted but not sampled
+thread_local bool sampling = false;
+
+uint32_t CaptureStack(void** stack) {
+#if defined(RENGINE_HAS_BACKTRACE)
+    return backtrace(stack, MAX_STACK_DEPTH);
+#else
+    stack[0] = __builtin_return_address(0);
+    return 1;
+#endif
+}
+
+[[maybe_unused]] void CountAllocation(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+
+    const uint32_t period = samplePeriod.load(std::memory_order_relaxed);
+    if (period == 0 || sampling || sampleCountdown.fetch_add(1, std::memory_order_relaxed) % period != 0) {
+        return;
+    }
+    sampling = true;
+    Sample& sample = samples[sampleHead.fetch_add(1, std::memory_order_relaxed) % SAMPLE_CAPACITY];
+    sample.size = size;
+    sample.depth = CaptureStack(sample.stack);
+    sampling = false;
+}
+
+[[maybe_unused]] void CountFree(void* p) {
+    if (p) {
+        frees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+Counters Counters::operator-(const Counters& other) const {
+    return Counters{
+        .allocations = allocations - other.allocations,
+        .frees = frees - other.frees,
+        .bytes = bytes - other.bytes,
+    };
+}
+
+bool Enabled() {
+#if defined(RENGINE_TRACK_ALLOCATIONS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+Counters Totals() {
+    return Counters{
+        .allocations = allocations.load(std::memory_order_relaxed),
+        .frees = frees.load(std::memory_order_relaxed),
+        .bytes = bytes.load(std::memory_order_relaxed),
+    };
+}
+
+void StartSampling(uint32_t period) {
+    // the first backtrace loads the unwinder, better outside of a frame
+    void* stack[MAX_STACK_DEPTH];
+    CaptureStack(stack);
+
+    sampleHead.store(0, std::memory_order_relaxed);
+    sampleCountdown.store(0, std::memory_order_relaxed);
+    samplePeriod.store(period, std::memory_order_relaxed);
+}
+
+void StopSampling() {
+    samplePeriod.store(0, std::memory_order_relaxed);
+}
+
+std::vector<Sample> CollectSamples() {
+    const uint64_t head = sampleHead.load(std::memory_order_relaxed);
+    const uint64_t begin = head > SAMPLE_CAPACITY ? head - SAMPLE_CAPACITY : 0;
+    std::vector<Sample> result;
+    for (uint64_t i = begin; i < head; ++i) {
+        result.push_back(samples[i % SAMPLE_CAPACITY]);
+    }
+    return result;
+}
+
+void PrintSamples(std::ostream& out) {
+    struct Site {
+        Sample sample;
+        uint32_t count;
+        uint64_t bytes;
+    };
+    std::vector<Site> sites;
+    for (const Sample& sample : CollectSamples()) {
+        auto same = [&](const Site& site) {
+            return site.sample.depth == sample.depth &&
+                   std::equal(sample.stack, sample.stack + sample.depth, site.sample.stack);
+        };
+        auto it = std::find_if(sites.begin(), sites.end(), same);
+        if (it == sites.end()) {
+            sites.push_back(Site{sample, 0, 0});
+            it = sites.end() - 1;
+        }
+        ++it->count;
+        it->bytes += sample.size;
+    }
+    std::sort(sites.begin(), sites.end(), [](const Site& l, const Site& r) {
+        return l.count > r.count;
+    });
+
+    for (const Site& site : sites) {
+        out << site.count << " sampled allocations, " << site.bytes << " bytes:\n";
+#if defined(RENGINE_HAS_BACKTRACE)
+        char** symbols = backtrace_symbols(site.sample.stack, site.sample.depth);
+#else
+        char** symbols = nullptr;
+#endif
+        for (uint32_t i = 0; i < site.sample.depth; ++i) {
+            out << "    ";
+            if (symbols) {
+                out << symbols[i];
+            } else {
+                out << site.sample.stack[i];
+            }
+            out << '\n';
+        }
+        std::free(symbols);
+    }
+}
+
+} // namespace AllocTracker
+
+#if defined(RENGINE_TRACK_ALLOCATIONS)
+
+void* operator new(size_t size) {
+    AllocTracker::CountAllocation(size);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    AllocTracker::CountAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    AllocTracker::CountFree(p);
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    operator delete(p);
+}
+
+#endif
@@ -2,6 +2,16 @@
 
 namespace ExtMath {
 
+namespace {
+
+std::mt19937_64& Randomizer()
+{
+    static std::mt19937_64 randomizer(std::time(0));
+    return randomizer;
+}
+
+} // namespace
+
 const long double PI = 3.14159265359;
 
 double ToRadian(double a)
@@ -38,6 +48,11 @@ double Sigmoid(float x, float a)
     return 1 / (1 + exp(-x * a));
 }
 
+void SeedRandom(uint64_t seed)
+{
+    Randomizer().seed(seed);
+}
+
 int Sign(double a)
 {
     if (a == 0)    return 0;
@@ -52,8 +67,7 @@ double RandomDouble(double a, double b)
         return 0;
     }
 
-    static std::mt19937_64 randomizer(std::time(0));
-    long double base = randomizer(); /* in range [0; ULLONG_MAX) */
+    long double base = Randomizer()(); /* in range [0; ULLONG_MAX) */
     long double maxr = ULLONG_MAX;
     long double normilized = base / maxr; /* in range [0; ULLONG_MAX) */
     return normilized * (b - a) + a;
@@ -66,8 +80,7 @@ int RandomInt(int a, int b)
         return 0;
     }
 
-    static std::mt19937_64 randomizer(std::time(0));
-    unsigned long long base = randomizer(); /* in range [0; ULLONG_MAX) */
+    unsigned long long base = Randomizer()(); /* in range [0; ULLONG_MAX) */
     long long normilized = base % (b - a);
     return normilized + a;
 }
@@ -77,11 +90,6 @@ double Interpolate(double a0, double a1, double p)
 	return a1 * p + (1 - p) * a0;
 }
 
-double Smootherstep(double a0, double a1, double p)
-{
-	return (a1 - a0) * ((p * (p * 6.0 - 15.0) + 10.0) * p * p * p) + a0;
-}
-
 double InterpolateSquare(double p00, double p10, double p01, double p11, Vec2<double> p)
 {
 	return Interpolate(
@@ -91,15 +99,6 @@ double InterpolateSquare(double p00, double p10, double p01, double p11, Vec2<do
 	);
 }
 
-double SmootherstepSquare(double p00, double p10, double p01, double p11, Vec2<double> p)
-{
-	return Smootherstep(
-		Smootherstep(p00, p10, p.x),
-		Smootherstep(p01, p11, p.x),
-		p.y
-	);
-}
-
 double ModuleStepFunction(double x) {
     return x / (1 + std::abs(x));
 }
@@ -0,0 +1,148 @@
+#include <library/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Parallel {
+
+namespace {
+
+struct Job {
+    const Body* body;
+    size_t begin;
+    size_t end;
+    size_t chunk;
+    std::atomic<size_t> nextChunk{0};
+};
+
+thread_local bool insideFor = false;
+
+class Pool {
+public:
+    static Pool& Instance() {
+        static Pool pool;
+        return pool;
+    }
+
+    size_t ThreadCount() const {
+        return _workers.size() + 1;
+    }
+
+    void Run(Job& job) {
+        std::lock_guard<std::mutex> runLock(_runMutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = &job;
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        Drain(job);
+
+        // workers may still hold the job, it lives on this stack
+        std::unique_lock<std::mutex> lock(_mutex);
+        _job = nullptr;
+        _idle.wait(lock, [&] { return _busyWorkers == 0; });
+    }
+
+private:
+    Pool() {
+        size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 1; i < hardware; ++i) {
+            _workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    void WorkerLoop() {
+        uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _wake.wait(lock, [&] { return _stop || (_job && _generation != seenGeneration); });
+            if (_stop) {
+                return;
+            }
+            seenGeneration = _generation;
+            Job* job = _job;
+            ++_busyWorkers;
+            lock.unlock();
+
+            Drain(*job);
+
+            lock.lock();
+            if (--_busyWorkers == 0) {
+                _idle.notify_all();
+            }
+        }
+    }
+
+    static void Drain(Job& job) {
+        insideFor = true;
+        while (true) {
+            size_t start = job.begin + job.nextChunk.fetch_add(1) * job.chunk;
+            if (start >= job.end) {
+                break;
+            }
+            (*job.body)(start, std::min(job.end, start + job.chunk));
+        }
+        insideFor = false;
+    }
+
+    std::vector<std::thread> _workers;
+
+    // serializes For calls from different threads
+    std::mutex _runMutex;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    Job* _job = nullptr;
+    uint64_t _generation = 0;
+    uint32_t _busyWorkers = 0;
+    bool _stop = false;
+};
+
+} // namespace
+
+size_t ThreadCount()
+{
+    return Pool::Instance().ThreadCount();
+}
+
+void For(size_t begin, size_t end, size_t grain, Body body)
+{
+    if (begin >= end) {
+        return;
+    }
+    Pool& pool = Pool::Instance();
+    size_t count = end - begin;
+    // a few chunks per thread balance uneven rows without much scheduling overhead
+    size_t chunk = std::max<size_t>(std::max<size_t>(grain, 1), count / (pool.ThreadCount() * 4));
+    if (insideFor || pool.ThreadCount() == 1 || chunk >= count) {
+        body(begin, end);
+        return;
+    }
+
+    Job job;
+    job.body = &body;
+    job.begin = begin;
+    job.end = end;
+    job.chunk = chunk;
+    pool.Run(job);
+}
+
+} // namespace Parallel
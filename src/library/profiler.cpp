@@ -0,0 +1,151 @@
+#include <library/profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace Profiler {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(uint32_t id)
+        : events(RING_CAPACITY)
+        , threadId(id)
+    {}
+
+    std::vector<Event> events;
+    std::atomic<uint64_t> head{0};
+    uint32_t depth = 0;
+    const uint32_t threadId;
+};
+
+struct Registry {
+    std::mutex mutex;
+    // buffers outlive their threads so zones of finished workers can still be exported
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    SteadyClock::time_point epoch = SteadyClock::now();
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer& LocalBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto b = std::make_shared<ThreadBuffer>(registry.buffers.size());
+        registry.buffers.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+void WriteEscaped(std::ostream& out, const char* s) {
+    for (; *s; ++s) {
+        switch (*s) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(*s) >= 0x20) {
+                out << *s;
+            }
+            break;
+        }
+    }
+}
+
+} // namespace
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            SteadyClock::now() - GetRegistry().epoch).count();
+}
+
+void Record(const char* name, int64_t startNs, int64_t endNs, uint32_t depth) {
+    ThreadBuffer& buffer = LocalBuffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % RING_CAPACITY] = Event{
+        .name = name,
+        .startNs = startNs,
+        .durationNs = endNs - startNs,
+        .depth = depth,
+        .threadId = buffer.threadId,
+    };
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::vector<Event> Collect() {
+    std::vector<Event> result;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& buffer : registry.buffers) {
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t begin = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+            for (uint64_t i = begin; i < head; ++i) {
+                result.push_back(buffer->events[i % RING_CAPACITY]);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Event& l, const Event& r) {
+        return l.startNs < r.startNs || (l.startNs == r.startNs && l.depth < r.depth);
+    });
+    return result;
+}
+
+void Clear() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers) {
+        buffer->head.store(0, std::memory_order_release);
+    }
+}
+
+bool ExportChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    std::vector<Event> events = Collect();
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i];
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":\"";
+        WriteEscaped(out, e.name);
+        // chrome trace timestamps are microseconds
+        out << "\",\"cat\":\"rengine\",\"ph\":\"X\",\"pid\":1"
+            << ",\"tid\":" << e.threadId
+            << ",\"ts\":" << e.startNs / 1000 << '.' << e.startNs % 1000 / 100
+            << ",\"dur\":" << e.durationNs / 1000 << '.' << e.durationNs % 1000 / 100
+            << ",\"args\":{\"depth\":" << e.depth << "}}";
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+ScopedZone::ScopedZone(const char* name)
+    : _name(name)
+    , _depth(LocalBuffer().depth++)
+    , _startNs(NowNs())
+{}
+
+ScopedZone::~ScopedZone() {
+    int64_t end = NowNs();
+    --LocalBuffer().depth;
+    Record(_name, _startNs, end, _depth);
+}
+
+} // namespace Profiler
@@ -0,0 +1,122 @@
+#include "world.h"
+#include "parse_config.h"
+
+#include <core/headless_graphics.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// FloatWorldReference out     - generates the seeded default world at SIZE x SIZE in double
+//                               and writes its heights, normals and shaded frame to out
+// FloatWorldDeviation in      - generates the same world in float (RENGINE_FLOAT_WORLD) and
+//                               fails with exit code 2 if it strays from the reference in in
+//                               further than the bounds below
+
+namespace {
+
+constexpr uint32_t SIZE = 256;
+
+// Perlin alone strays about 1e-5 of the [-1, 1] height range. The transformer scales it to
+// the height units of the map (mountains are above 7) and erosion amplifies it on steep slopes
+constexpr double MAX_HEIGHT_DEVIATION = 0.1;
+constexpr double MAX_NORMAL_DEVIATION = 0.05;
+// Colors differ by a step of rounding. A cell whose height or slope sits on a biome bound may
+// flip to the neighbouring biome, those stay a small share of the frame
+constexpr int COLOR_TOLERANCE = 2;
+constexpr double MAX_SHARE_BEYOND_TOLERANCE = 1e-3;
+
+struct Snapshot {
+    std::vector<double> heights;
+    std::vector<Vec3d> normals;
+    std::vector<sf::Uint8> pixels;
+};
+
+Snapshot Generate() {
+    Config config = ParseConfigFromFile("world_settings.json");
+    config.seed = 1;
+    config.worldSize = Vec2u(SIZE, SIZE);
+
+    World world;
+    world.Generate(config);
+    // mid-afternoon, the sun is up and mountains cast shadows
+    world.Tick(config.dayDuration * 3 / 8);
+    HeadlessGraphics graphics(Vec2i(SIZE, SIZE));
+    world.Render(&graphics, Vec2u(SIZE, SIZE));
+
+    Snapshot snapshot;
+    for (uint32_t y = 0; y < SIZE; ++y) {
+        for (uint32_t x = 0; x < SIZE; ++x) {
+            snapshot.heights.push_back(world.Height(x, y));
+            snapshot.normals.push_back(world.Normal(x, y));
+        }
+    }
+    snapshot.pixels.assign(graphics.Pixels(), graphics.Pixels() + 4 * SIZE * SIZE);
+    return snapshot;
+}
+
+template<typename T>
+void Transfer(std::fstream& file, std::vector<T>& data, bool write) {
+    if (write) {
+        file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+    } else {
+        file.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(T));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " reference" << std::endl;
+        return 1;
+    }
+    Snapshot snapshot = Generate();
+
+#if !defined(RENGINE_FLOAT_WORLD)
+    std::fstream out(argv[1], std::ios::out | std::ios::binary);
+    Transfer(out, snapshot.heights, true);
+    Transfer(out, snapshot.normals, true);
+    Transfer(out, snapshot.pixels, true);
+    return out ? 0 : 1;
+#else
+    Snapshot reference = snapshot;
+    std::fstream in(argv[1], std::ios::in | std::ios::binary);
+    Transfer(in, reference.heights, false);
+    Transfer(in, reference.normals, false);
+    Transfer(in, reference.pixels, false);
+    if (!in) {
+        std::cerr << "cannot read the reference " << argv[1] << std::endl;
+        return 1;
+    }
+
+    double height = 0;
+    double normal = 0;
+    for (size_t i = 0; i < snapshot.heights.size(); ++i) {
+        height = std::max(height, std::abs(snapshot.heights[i] - reference.heights[i]));
+        Vec3d d = snapshot.normals[i] - reference.normals[i];
+        normal = std::max({normal, std::abs(d.x), std::abs(d.y), std::abs(d.z)});
+    }
+    int color = 0;
+    size_t beyond = 0;
+    for (size_t i = 0; i < snapshot.pixels.size(); i += 4) {
+        int pixel = 0;
+        for (size_t c = i; c < i + 4; ++c) {
+            pixel = std::max(pixel, std::abs(snapshot.pixels[c] - reference.pixels[c]));
+        }
+        color = std::max(color, pixel);
+        beyond += pixel > COLOR_TOLERANCE;
+    }
+    const double share = 4. * beyond / snapshot.pixels.size();
+
+    std::printf("max deviation: height %.3g normal %.3g color %d, pixels beyond %d: %.3g\n",
+            height, normal, color, COLOR_TOLERANCE, share);
+    if (height > MAX_HEIGHT_DEVIATION || normal > MAX_NORMAL_DEVIATION || share > MAX_SHARE_BEYOND_TOLERANCE) {
+        std::fprintf(stderr, "float world strays beyond height %.3g normal %.3g, or pixels beyond %d over %.3g\n",
+                MAX_HEIGHT_DEVIATION, MAX_NORMAL_DEVIATION, COLOR_TOLERANCE, MAX_SHARE_BEYOND_TOLERANCE);
+        return 2;
+    }
+    return 0;
+#endif
+}
@@ -0,0 +1,37 @@
+#include "world.h"
+#include "parse_config.h"
+
+#include <library/alloc_tracker.h>
+
+#include <iostream>
+
+// RegenerateAllocations - generates the seeded default world at 256 x 256, then fails with
+//                         exit code 2 if regenerating it at the same size allocates
+int main() {
+    if (!AllocTracker::Enabled()) {
+        std::cerr << "needs a build with -DRENGINE_TRACK_ALLOCATIONS=ON" << std::endl;
+        return 1;
+    }
+    Config config = ParseConfigFromFile("world_settings.json");
+    config.seed = 1;
+    config.worldSize = Vec2u(256, 256);
+
+    World world;
+    world.Generate(config);
+    // the first regeneration shades the map generated before it, as the first Render would
+    world.Regenerate();
+
+    const AllocTracker::Counters start = AllocTracker::Totals();
+    AllocTracker::StartSampling(1);
+    world.Regenerate();
+    AllocTracker::StopSampling();
+    const uint64_t allocations = (AllocTracker::Totals() - start).allocations;
+
+    std::cout << "regenerate_allocations " << allocations << std::endl;
+    if (allocations > 0) {
+        std::cerr << "regenerating allocated, sampled call stacks:" << std::endl;
+        AllocTracker::PrintSamples(std::cerr);
+        return 2;
+    }
+    return 0;
+}